@@ -1,7 +1,5 @@
 #include "AlgImpl.h"
 
-#define PI 3.14159265
-
 // This function implements the naive algorithm for polynomial evaluation
 // Pre: A vector of polynomials to evaluate at each of the roots of unity
 //      result - a vector to store the results of the naive evaluation in
@@ -9,73 +7,102 @@
 // Throws: -1 if no polynomial exists yet
 int naivePolyEval(std::vector<Poly> &polys, std::vector<Poly> &result)
 {
-   int n=polys.size();      
-   if (n==0) //Check to see if we have a polynomial
+   static thread_local PolySoA coeffs, values;
+   if(polys.size()==0) //Check to see if we have a polynomial
    {
       return -1;
    }
-   else
-   {
-      for(int k=0; k<n; k++)
-      {
-         //determine root of unity to evaluate at...
-         double theta = (2*PI*k)/n;
-         Poly curRoot = Poly(cos(theta), sin(theta));
-         std::vector<Poly> exponents(n);
-         //genExponents(curRoot, n, exponents);
-         genExponentsNaive(curRoot, n, exponents);
+   coeffs.fromPolys(polys);
+   naivePolyEval(coeffs, values);
+   values.toPolys(result);
+   return 0;
+}
 
-         double sumR = polys[0].getReal();
-         double sumI = polys[0].getImag();
+// This function is the same as below for a PolySoA
+int naivePolyEval(const PolySoA &polys, PolySoA &result)
+{
+   return naivePolyEval(polys.realData(), polys.imagData(), polys.size(), result);
+}
 
-         for(int j=1; j<n; j++)
-         {
-            Poly curPoly = polys.at(j);
-            Poly curExponent = exponents.at(j-1);
-            sumR += (curPoly.getReal() * curExponent.getReal()) + ( (-1)*curPoly.getImag()*curExponent.getImag());
-            sumI += (curPoly.getReal()*curExponent.getImag()) + (curPoly.getImag()*curExponent.getReal());
-         }
-         result[k]=Poly(sumR, sumI);
-      }
+// This function turns bytes counted for double values into bytes of values
+// of scalar type T, every cost below counts 8 bytes per scalar
+template <typename T>
+static int64_t scaledBytes(int64_t bytes)
+{
+   return bytes/(int64_t)sizeof(double)*(int64_t)sizeof(T);
+}
+
+// This function gives the flops and the bytes loaded and stored by the naive
+// algorithm below. A complex multiply is 6 flops, a multiply-add 8. Every
+// root builds its ith power with i multiplies, writes the n powers, reads
+// them back with the coefficients and writes one value.
+static void naiveCost(int64_t n, int64_t &flops, int64_t &bytes)
+{
+   flops = n*(6*(n*(n-1)/2) + 8*(n-1));
+   bytes = n*(16*n + 32*(n-1) + 32);
+}
+
+// This function is the structure of arrays version of the naive algorithm
+// that the one above converts to
+// Pre: coeffReal, coeffImag - the n coefficients of a polynomial to evaluate
+//      at each of the roots of unity, in any storage (e.g. a mapped file)
+//      result - resized to hold the results of the naive evaluation
+// Post: All nth roots of unity have been computed naively
+// Throws: -1 if no polynomial exists yet
+int naivePolyEval(const double *coeffReal, const double *coeffImag, int n, PolySoA &result)
+{
+   if (n==0) //Check to see if we have a polynomial
+   {
+      return -1;
    }
-   return 0;
+   result.resize(n);
+   return naivePolyEval(coeffReal, coeffImag, n, result.realData(), result.imagData());
 }
 
-// This function is the same as the one above, but keeps track
-// of the # of complex multiplies
-int naivePolyEvalCounts(std::vector<Poly> &polys, int64_t &count)
+// This function is the same as above in any scalar type T, float and
+// double-double evaluations run it too
+// Pre: outReal, outImag - room for n values
+template <typename T>
+int naivePolyEval(const T *coeffReal, const T *coeffImag, int n, T *outReal, T *outImag)
 {
-   int n=polys.size();      
    if (n==0) //Check to see if we have a polynomial
    {
       return -1;
    }
    else
    {
-      for(int k=0; k<n; k++)
+      std::shared_ptr<const BasicFFTPlan<T> > plan = getFFTPlan<T>(n);
+      InstrumentPhase phase("evaluate");
+      if(phase.active())
       {
-         //determine root of unity to evaluate at...
-         double theta = (2*PI*k)/n;
-         Poly curRoot = Poly(cos(theta), sin(theta));
-         std::vector<Poly> exponents(n);
-         genExponentsNaiveCounts(curRoot, n, exponents, count);
+         int64_t flops, bytes;
+         naiveCost(n, flops, bytes);
+         phase.count(flops, scaledBytes<T>(bytes));
+      }
+      //the roots are independent, each thread takes a range of them
+      parallelFor(0, n, [&](int kBegin, int kEnd)
+      {
+         WorkspaceFrame frame;
+         T *expReal = frame.allocate<T>(n);
+         T *expImag = frame.allocate<T>(n);
+         for(int k=kBegin; k<kEnd; k++)
+         {
+            //determine root of unity to evaluate at...
+            typename ComplexOf<T>::type curRoot(plan->rootReal(k), plan->rootImag(k));
+            genExponentsNaive(curRoot, n, expReal, expImag);
 
-         double sumR = polys[0].getReal();
-         double sumI = polys[0].getImag();
+            T sumR = coeffReal[0];
+            T sumI = coeffImag[0];
 
-         for(int j=1; j<n; j++)
-         {
-            Poly curPoly = polys.at(j);
-            Poly curExponent = exponents.at(j-1);
-            if(round(curPoly.getImag())!=0 || round(curExponent.getImag())!=0)
+            for(int j=1; j<n; j++)
             {
-               count++;
+               sumR += (coeffReal[j] * expReal[j-1]) + ( (-1)*coeffImag[j]*expImag[j-1]);
+               sumI += (coeffReal[j]*expImag[j-1]) + (coeffImag[j]*expReal[j-1]);
             }
-            sumR += (curPoly.getReal() * curExponent.getReal()) + ( (-1)*curPoly.getImag()*curExponent.getImag());
-            sumI += (curPoly.getReal()*curExponent.getImag()) + (curPoly.getImag()*curExponent.getReal());
+            outReal[k] = sumR;
+            outImag[k] = sumI;
          }
-         //Poly foo(sumR, sumI);
-      }
+      });
    }
    return 0;
 }
@@ -122,32 +149,34 @@ void genExponentsNaive(Poly base, int n, std::vector<Poly> &result)
    }
 }
 
-// This function is the same as above, but keeps track of the # of complex multiplies
-void genExponentsNaiveCounts(Poly base, int n, std::vector<Poly> &result, int64_t &count)
+// This function is the same as above, writing into a structure of arrays
+void genExponentsNaive(Poly base, int n, PolySoA &result)
 {
-   result[0] = base;
-   double baseR = base.getReal();
-   double baseI = base.getImag();
+   genExponentsNaive(base, n, result.realData(), result.imagData());
+}
+
+// This function is the same as above, writing into any split storage, for
+// a base of any complex type
+template <typename C>
+void genExponentsNaive(C base, int n, typename ScalarOf<C>::type *resultReal, typename ScalarOf<C>::type *resultImag)
+{
+   typedef typename ScalarOf<C>::type T;
+   T baseR = base.getReal();
+   T baseI = base.getImag();
+   resultReal[0] = baseR;
+   resultImag[0] = baseI;
    for(int i=1; i<n; i++)
    {
-      double R = baseR; 
-      double I = baseI;
+      T R = baseR; 
+      T I = baseI;
       for(int j=i; j>0; j--)
       {
-         if(round(I)!=0 || round(baseI)!=0)
-         {
-            count++;
-         }
-         /*if(round(I)==0 && round(baseI)==0) {}
-         else
-         {
-            count++;
-         }*/
-         double tempR = R;
+         T tempR = R;
          R = R*baseR + (-1)*I*baseI;
          I = tempR*baseI + baseR*I;
       }
-      result[i] = Poly(R,I);
+      resultReal[i] = R;
+      resultImag[i] = I;
    }
 }
 
@@ -157,138 +186,218 @@ void genExponentsNaiveCounts(Poly base, int n, std::vector<Poly> &result, int64_
 // Throws: -1 if no polynomial exists yet
 int hornerEval(std::vector<Poly> &polys, std::vector<Poly> &result)
 {
-   int n = polys.size();
-   if (n==0) //Check to see if we have a polynomial
+   static thread_local PolySoA coeffs, values;
+   if(polys.size()==0) //Check to see if we have a polynomial
    {
       return -1;
    }
-   else
+   coeffs.fromPolys(polys);
+   hornerEval(coeffs, values);
+   values.toPolys(result);
+   return 0;
+}
+
+// This function is the same as below for a PolySoA
+int hornerEval(const PolySoA &polys, PolySoA &result)
+{
+   return hornerEval(polys.realData(), polys.imagData(), polys.size(), result);
+}
+
+// This function gives the flops and the bytes loaded and stored by horners
+// algorithm at m points: a complex multiply-add, 8 flops, per point and
+// coefficient after the last. Each block of points reads every coefficient
+// once, and every step loads and stores the point's value and loads the point.
+static void hornerCost(int64_t n, int64_t m, int64_t &flops, int64_t &bytes)
+{
+   const int64_t blockSize = 256;
+   flops = 8*m*(n-1);
+   bytes = (m+blockSize-1)/blockSize*16*n + 16*m + 48*m*(n-1);
+}
+
+// This function is the structure of arrays version of horners algorithm.
+// Pre: coeffReal, coeffImag - the n coefficients of a polynomial to evaluate
+//      at each of the roots of unity, in any storage (e.g. a mapped file)
+//      result - resized to hold the results of horners algorithm
+// Post: All nth roots of unity have been computed using horners algorithm 
+// Throws: -1 if no polynomial exists yet
+int hornerEval(const double *coeffReal, const double *coeffImag, int n, PolySoA &result)
+{
+   if (n==0) //Check to see if we have a polynomial
    {
-      for(int k=0; k<n; k++)
-      {
-         //determine root of unity to evaluate at...
-         double theta = (2*PI*k)/n;
-         Poly curRoot = Poly(cos(theta), sin(theta));
-         double aReal=0, aImag=0;
-         double bReal = polys.at(polys.size()-1).getReal();
-         double bImag = polys.at(polys.size()-1).getImag();
-         double bRealTemp;
-         for(int i=(polys.size()-2); i>-1; i--)
-         {
-            aReal = polys.at(i).getReal();
-            aImag = polys.at(i).getImag();
-            bRealTemp = bReal;
-            bReal = ((bReal*curRoot.getReal()) + ((-1)*bImag*curRoot.getImag())) + aReal;
-            bImag = ((bRealTemp*curRoot.getImag())+(bImag*curRoot.getReal())) + aImag;
-         }
-         result[k] = Poly(bReal, bImag);
-      }
+      return -1;
    }
-   return 0;
+   result.resize(n);
+   return hornerEval(coeffReal, coeffImag, n, result.realData(), result.imagData());
 }
 
-// This function is the same as above, but keeps track of the number
-// of complex multiplies
-int hornerEvalCounts(std::vector<Poly> &polys, int &count)
+// This function is the same as above in any scalar type T, float and
+// double-double evaluations run it too
+// Pre: outReal, outImag - room for n values
+template <typename T>
+int hornerEval(const T *coeffReal, const T *coeffImag, int n, T *outReal, T *outImag)
 {
-   int n = polys.size();
    if (n==0) //Check to see if we have a polynomial
    {
       return -1;
    }
    else
    {
-      for(int k=0; k<n; k++)
+      std::shared_ptr<const BasicFFTPlan<T> > plan = getFFTPlan<T>(n);
+      InstrumentPhase phase("evaluate");
+      if(phase.active())
       {
-         //determine root of unity to evaluate at...
-         double theta = (2*PI*k)/n;
-         Poly curRoot = Poly(cos(theta), sin(theta));
-         double aReal=0, aImag=0;
-         double bReal = polys.at(polys.size()-1).getReal();
-         double bImag = polys.at(polys.size()-1).getImag();
-         double bRealTemp;
-         for(int i=(polys.size()-2); i>-1; i--)
-         {
-            aReal = polys.at(i).getReal();
-            aImag = polys.at(i).getImag();
-            if(round(aImag)!=0 || round(bImag)!=0)
-               count++;
-            bRealTemp = bReal;
-            bReal = ((bReal*curRoot.getReal()) + ((-1)*bImag*curRoot.getImag())) + aReal;
-            bImag = ((bRealTemp*curRoot.getImag())+(bImag*curRoot.getReal())) + aImag;
-         }
+         int64_t flops, bytes;
+         hornerCost(n, n, flops, bytes);
+         phase.count(flops, scaledBytes<T>(bytes));
       }
+      hornerEvalAt(coeffReal, coeffImag, n, plan->rootsReal(), plan->rootsImag(), n, outReal, outImag);
    }
    return 0;
 }
 
+// This function runs horners algorithm at m arbitrary points. The loops are
+// interchanged so each coefficient is folded into a block of points at
+// once: every point keeps its own independent chain, which the compiler
+// can vectorize, and each point still sees exactly the same sequence of
+// operations as the one-point-at-a-time version.
+// Pre: coeffReal, coeffImag - n > 0 coefficients
+//      pointReal, pointImag - the m points
+//      outReal, outImag - room for m values
+// Post: out holds the polynomial evaluated at every point
+template <typename T>
+void hornerEvalAt(const T *__restrict__ coeffReal, const T *__restrict__ coeffImag, int n,
+                  const T *__restrict__ pointReal, const T *__restrict__ pointImag, int m,
+                  T *__restrict__ outReal, T *__restrict__ outImag)
+{
+   //block of points whose partial sums stay in L1 while the coefficients
+   //stream by, the blocks are shared out between the threads
+   const int blockSize = 256;
+   int blocks = (m+blockSize-1)/blockSize;
+   parallelFor(0, blocks, [&](int blockBegin, int blockEnd)
+   {
+      for(int kStart=blockBegin*blockSize; kStart<std::min(m, blockEnd*blockSize); kStart+=blockSize)
+      {
+         int kEnd = std::min(m, kStart+blockSize);
+         for(int k=kStart; k<kEnd; k++)
+         {
+            outReal[k] = coeffReal[n-1];
+            outImag[k] = coeffImag[n-1];
+         }
+         for(int i=n-2; i>-1; i--)
+         {
+            T aReal = coeffReal[i];
+            T aImag = coeffImag[i];
+            for(int k=kStart; k<kEnd; k++)
+            {
+               T bRealTemp = outReal[k];
+               outReal[k] = ((bRealTemp*pointReal[k]) + ((-1)*outImag[k]*pointImag[k])) + aReal;
+               outImag[k] = ((bRealTemp*pointImag[k])+(outImag[k]*pointReal[k])) + aImag;
+            }
+         }
+      }
+   });
+}
+
+// This function implements the naive algorithm with the powers of each root
+// built by repeated squaring
+// Pre: A vector of polynomials to evaluate at each of the roots of unity
+//      result - a vector to store the results of the evaluation in
+// Post: All nth roots of unity have been computed
+// Throws: -1 if no polynomial exists yet
 int repeatedSquaringEval(std::vector<Poly> &polys, std::vector<Poly> &result)
 {
-   int n = polys.size();
-   if (n==0) //Check to see if we have a polynomial
+   static thread_local PolySoA coeffs, values;
+   if(polys.size()==0) //Check to see if we have a polynomial
    {
       return -1;
    }
-   else
-   {
-      for(int k=0; k<n; k++)
-      {
-         //determine root of unity to evaluate at...
-         double theta = (2*PI*k)/n;
-         Poly curRoot = Poly(cos(theta), sin(theta));
-         std::vector<Poly> exponents(n);
+   coeffs.fromPolys(polys);
+   repeatedSquaringEval(coeffs, values);
+   values.toPolys(result);
+   return 0;
+}
 
-         repeatedSquaringExp(curRoot, n, exponents);
+// This function is the same as below for a PolySoA
+int repeatedSquaringEval(const PolySoA &polys, PolySoA &result)
+{
+   return repeatedSquaringEval(polys.realData(), polys.imagData(), polys.size(), result);
+}
 
-         double sumR = polys[0].getReal();
-         double sumI = polys[0].getImag();
+// This function gives the flops and the bytes loaded and stored by repeated
+// squaring: per root one complex multiply for the square, the multiplies of
+// repeatedSquaringExp for the higher powers and a multiply-add per
+// coefficient after the first, with the n-1 powers written and read back
+static void repeatedSquaringCost(int64_t n, int64_t &flops, int64_t &bytes)
+{
+   int64_t multiplies = n >= 2 ? 1 : 0;
+   for(int64_t i=3; i<n; i++)
+   {
+      multiplies += i%2 == 0 ? i/2-1 : (i-1)/2;
+   }
+   flops = n*(6*multiplies + 8*(n-1));
+   bytes = n*(16*std::max<int64_t>(n-1, 1) + 32*(n-1) + 32);
+}
 
-         for(int j=1; j<n; j++)
-         {
-            Poly curPoly = polys.at(j);
-            Poly curExponent = exponents.at(j-1);
-            sumR += (curPoly.getReal() * curExponent.getReal()) + ( (-1)*curPoly.getImag()*curExponent.getImag());
-            sumI += (curPoly.getReal()*curExponent.getImag()) + (curPoly.getImag()*curExponent.getReal());
-         }
-         result[k] = Poly(sumR, sumI);
-      }
+// This function is the structure of arrays version of the one above
+// Pre: coeffReal, coeffImag - the n coefficients of a polynomial to evaluate
+//      at each of the roots of unity, in any storage (e.g. a mapped file)
+//      result - resized to hold the results of the evaluation
+// Post: All nth roots of unity have been computed
+// Throws: -1 if no polynomial exists yet
+int repeatedSquaringEval(const double *coeffReal, const double *coeffImag, int n, PolySoA &result)
+{
+   if (n==0) //Check to see if we have a polynomial
+   {
+      return -1;
    }
-   return 0;
+   result.resize(n);
+   return repeatedSquaringEval(coeffReal, coeffImag, n, result.realData(), result.imagData());
 }
 
-int repeatedSquaringEvalCounts(std::vector<Poly> &polys, int64_t &count)
+// This function is the same as above in any scalar type T, float and
+// double-double evaluations run it too
+// Pre: outReal, outImag - room for n values
+template <typename T>
+int repeatedSquaringEval(const T *coeffReal, const T *coeffImag, int n, T *outReal, T *outImag)
 {
-   int n = polys.size();
    if (n==0) //Check to see if we have a polynomial
    {
       return -1;
    }
    else
    {
-      for(int k=0; k<n; k++)
+      std::shared_ptr<const BasicFFTPlan<T> > plan = getFFTPlan<T>(n);
+      InstrumentPhase phase("evaluate");
+      if(phase.active())
       {
-         //determine root of unity to evaluate at...
-         double theta = (2*PI*k)/n;
-         Poly curRoot = Poly(cos(theta), sin(theta));
-         std::vector<Poly> exponents(n);
-
-         repeatedSquaringExpCounts(curRoot, n, exponents, count);
+         int64_t flops, bytes;
+         repeatedSquaringCost(n, flops, bytes);
+         phase.count(flops, scaledBytes<T>(bytes));
+      }
+      //the roots are independent, each thread takes a range of them
+      parallelFor(0, n, [&](int kBegin, int kEnd)
+      {
+         WorkspaceFrame frame;
+         T *expReal = frame.allocate<T>(n);
+         T *expImag = frame.allocate<T>(n);
+         for(int k=kBegin; k<kEnd; k++)
+         {
+            //determine root of unity to evaluate at...
+            typename ComplexOf<T>::type curRoot(plan->rootReal(k), plan->rootImag(k));
+            repeatedSquaringExp(curRoot, n, expReal, expImag);
 
-         double sumR = polys[0].getReal();
-         double sumI = polys[0].getImag();
+            T sumR = coeffReal[0];
+            T sumI = coeffImag[0];
 
-         for(int j=1; j<n; j++)
-         {
-            Poly curPoly = polys.at(j);
-            Poly curExponent = exponents.at(j-1);
-            if(round(curPoly.getImag())!=0 || round(curExponent.getImag())!=0)
+            for(int j=1; j<n; j++)
             {
-               count++;
+               sumR += (coeffReal[j] * expReal[j-1]) + ( (-1)*coeffImag[j]*expImag[j-1]);
+               sumI += (coeffReal[j]*expImag[j-1]) + (coeffImag[j]*expReal[j-1]);
             }
-            sumR += (curPoly.getReal() * curExponent.getReal()) + ( (-1)*curPoly.getImag()*curExponent.getImag());
-            sumI += (curPoly.getReal()*curExponent.getImag()) + (curPoly.getImag()*curExponent.getReal());
+            outReal[k] = sumR;
+            outImag[k] = sumI;
          }
-      }
+      });
    }
    return 0;
 }
@@ -328,24 +437,38 @@ void repeatedSquaringExp(Poly base, int n, std::vector<Poly> &result)
    }
 }
 
-void repeatedSquaringExpCounts(Poly base, int n, std::vector<Poly> &result, int64_t &count)
+// This function is the same as above, writing into a structure of arrays
+void repeatedSquaringExp(Poly base, int n, PolySoA &result)
 {
-   result[0] = base;
-   double xTwoR = base.getReal()*base.getReal() + (-1)*base.getImag()*base.getImag();
-   double xTwoI = base.getReal()*base.getImag() + base.getReal()*base.getImag();
-   result[1] = Poly(xTwoR, xTwoI);
+   repeatedSquaringExp(base, n, result.realData(), result.imagData());
+}
+
+// This function is the same as above, writing into any split storage, for
+// a base of any complex type
+template <typename C>
+void repeatedSquaringExp(C base, int n, typename ScalarOf<C>::type *resultReal, typename ScalarOf<C>::type *resultImag)
+{
+   typedef typename ScalarOf<C>::type T;
+   resultReal[0] = base.getReal();
+   resultImag[0] = base.getImag();
+   if(n < 2)
+   {
+      return;
+   }
+   T xTwoR = base.getReal()*base.getReal() + (-1)*base.getImag()*base.getImag();
+   T xTwoI = base.getReal()*base.getImag() + base.getReal()*base.getImag();
+   resultReal[1] = xTwoR;
+   resultImag[1] = xTwoI;
    for(int i=3; i<n; i++)
    {
-      double R = 0, I=0;
+      T R = 0, I=0;
       if(i%2 == 0)
       {
          R = xTwoR;
          I = xTwoI;
          for(int j=0; j<(i/2)-1; j++)
          {
-            if(round(I)!=0 || round(xTwoI)!=0)
-               count++;
-            double tempR = R;
+            T tempR = R;
             R = R*xTwoR + (-1)*I*xTwoI;
             I = tempR*xTwoI + xTwoR*I;
          }
@@ -356,35 +479,89 @@ void repeatedSquaringExpCounts(Poly base, int n, std::vector<Poly> &result, int6
          I = base.getImag();
          for(int j=0; j<((i-1)/2); j++)
          {
-            if(round(I)!=0 || round(xTwoI)!=0)
-            {
-               count++;
-            }
-            double tempR = R;
+            T tempR = R;
             R = R * xTwoR + (-1)*I*xTwoI;
             I = tempR*xTwoI + xTwoR*I;
          }
       }
-      result[i-1] = Poly(R, I);
+      resultReal[i-1] = R;
+      resultImag[i-1] = I;
    }
 }
 
+// This function tells whether every coefficient has a zero imaginary part
+bool isRealPoly(const Poly *polys, int n)
+{
+   for(int i=0; i<n; i++)
+   {
+      if(Poly(polys[i]).getImag() != 0)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// This function evaluates a polynomial at all nth roots of unity using the
+// FFT below. The coefficients are copied into result and transformed there,
+// so once result has been sized by a previous call no memory is allocated.
+// Pre: A vector of polynomials to evaluate at each of the roots of unity
+//      result - a vector to store the results of the FFT in
+// Post: result[k] holds the polynomial evaluated at the kth root of unity
+// Throws: -1 if no polynomial exists yet
 int callFFT(std::vector<Poly> &polys, std::vector<Poly> &result)
 {
-   int n=polys.size();
+   return callFFT(polys.empty() ? 0 : &polys[0], polys.size(), result);
+}
+
+// This function is the same as above for n coefficients in any storage,
+// e.g. an interleaved mapped file. The copy into result is the only pass
+// over the input before the transform. Real coefficients of an even count
+// are packed two to a complex value instead and go through realFFT, unless
+// the whole transform fits a codelet, which is faster than the packing.
+// Polynomials with only a few nonzero coefficients are cheaper through
+// callFFT(const SparsePoly&), which the caller has to choose.
+int callFFT(const Poly *polys, int n, std::vector<Poly> &result)
+{
    if(n==0)
    {
       return -1;
    }
+   else if(n%2 == 0 && n > maxCodeletSize && isRealPoly(polys, n))
+   {
+      result.resize(n);
+      {
+         InstrumentPhase phase("copy");
+         phase.count(0, 24*(int64_t)n);
+         for(int j=0; j<n/2; j++)
+         {
+            result[j] = Poly(Poly(polys[2*j]).getReal(), Poly(polys[2*j+1]).getReal());
+         }
+      }
+      realFFT(&result[0], n);
+      return 0;
+   }
    else
    {
-      result = fft(n, polys);
+      {
+         InstrumentPhase phase("copy");
+         phase.count(0, 32*(int64_t)n);
+         result.assign(polys, polys+n);
+      }
+      fft(result);
       return 0;
    }
 }
 
-int globalCount=0;
-int callFFTCount(std::vector<Poly> &polys, int &count)
+// This function is the structure of arrays version of callFFT. The
+// butterflies work on interleaved pairs, so the coefficients are gathered
+// into a workspace buffer, transformed and scattered back. All real input
+// of an even size is gathered two to a value for realFFT.
+// Pre: A polynomial to evaluate at each of the roots of unity
+//      result - resized to hold the results of the FFT
+// Post: result[k] holds the polynomial evaluated at the kth root of unity
+// Throws: -1 if no polynomial exists yet
+int callFFT(const PolySoA &polys, PolySoA &result)
 {
    int n=polys.size();
    if(n==0)
@@ -393,100 +570,575 @@ int callFFTCount(std::vector<Poly> &polys, int &count)
    }
    else
    {
-      globalCount=0;
-      std::vector<Poly> result = fftCount(n, polys);
-      count = globalCount;
+      WorkspaceFrame frame;
+      Poly *buffer = frame.allocate<Poly>(n);
+      const double *imag = polys.imagData();
+      if(n%2 == 0 && n > maxCodeletSize && std::find_if(imag, imag+n, [](double v) { return v != 0; }) == imag+n)
+      {
+         {
+            InstrumentPhase phase("split");
+            phase.count(0, 16*(int64_t)n);
+            for(int j=0; j<n/2; j++)
+            {
+               buffer[j] = Poly(polys.getReal(2*j), polys.getReal(2*j+1));
+            }
+         }
+         realFFT(buffer, n);
+      }
+      else
+      {
+         {
+            InstrumentPhase phase("split");
+            phase.count(0, 32*(int64_t)n);
+            for(int i=0; i<n; i++)
+            {
+               buffer[i] = Poly(polys.getReal(i), polys.getImag(i));
+            }
+         }
+         fft(buffer, n);
+      }
+      result.resize(n);
+      InstrumentPhase phase("join");
+      phase.count(0, 32*(int64_t)n);
+      for(int i=0; i<n; i++)
+      {
+         result.set(i, buffer[i].getReal(), buffer[i].getImag());
+      }
       return 0;
    }
 }
 
-std::vector<Poly> fft(int n, std::vector<Poly> polys)
+// This function recovers the coefficients of a polynomial from its values
+// at all nth roots of unity, the inverse of callFFT
+// Pre: values - the polynomial evaluated at the roots of unity
+//      result - a vector to store the coefficients in
+// Post: result holds the n coefficients
+// Throws: -1 if no values exist yet
+int callInverseFFT(std::vector<Poly> &values, std::vector<Poly> &result)
 {
-   if(n==1)
-      return polys;
-   else
+   if(values.empty())
    {
-      std::vector<Poly> tempEvens(n/2);
-      std::vector<Poly> tempOdds(n/2);
-      std::vector<Poly> result(n);
-      int countE=0, countO=0;
-      for(int i=0; i<n; i++)
+      return -1;
+   }
+   result.assign(values.begin(), values.end());
+   inverseFFT(result);
+   return 0;
+}
+
+// This function gives the flops and the bytes loaded and stored by a radix-2
+// FFT of n points. A butterfly is a complex multiply and two adds, 10 flops,
+// except in the codelets, whose butterflies with a twiddle of 1 or i take 4.
+// The codelets load and store every value once, the bit reversal and every
+// later pass load and store every value and the pass loads a twiddle per
+// butterfly.
+static void radix2Cost(int64_t n, int64_t &flops, int64_t &bytes)
+{
+   int64_t leafLen = std::min<int64_t>(n, maxCodeletSize);
+   flops = 0;
+   bytes = 32*n;
+   if(n > leafLen)
+   {
+      bytes += 32*n;
+   }
+   for(int64_t len=2; len<=n; len <<= 1)
+   {
+      int64_t trivial = len > leafLen ? 0 : (len >= 4 ? 2 : 1);
+      flops += n/len*(4*trivial + 10*(len/2-trivial));
+      if(len > leafLen)
       {
-         if(i%2 == 0)
-         {
-            tempEvens.at(countE) = polys[i];
-            countE++;
-         }
-         else
-         {
-            tempOdds.at(countO) = polys[i];
-            countO++;
-         }
+         bytes += 40*n;
       }
+   }
+}
+
+// This function is the same as above for the four-step FFT: the row and
+// column transforms, the two complex multiplies of every twiddle, the
+// gather and scatter of the columns with their two table reads and the
+// transpose, which moves the row halves first when n1 != n2
+static void fourStepCost(int64_t n, int64_t &flops, int64_t &bytes)
+{
+   int64_t n1 = 1;
+   while(2*n1*n1 < n)
+   {
+      n1 *= 2;
+   }
+   int64_t n2 = n/n1;
+   int64_t columnFlops, columnBytes, rowFlops, rowBytes;
+   radix2Cost(n1, columnFlops, columnBytes);
+   radix2Cost(n2, rowFlops, rowBytes);
+   flops = n2*columnFlops + n1*rowFlops + 12*n;
+   bytes = n2*columnBytes + n1*rowBytes + 96*n + (n1 == n2 ? 32*n : 64*n);
+}
 
-      std::vector<Poly> evens = fft(n/2, tempEvens);
-      std::vector<Poly> odds  = fft(n/2, tempOdds);
-      
-      for(int k=0; k<(n/2); k++)
+// This function is the same as above for radix2FFT, which hands large sizes
+// to the four-step FFT
+static void pow2Cost(int64_t n, int64_t &flops, int64_t &bytes)
+{
+   if(n >= getFourStepThreshold())
+   {
+      fourStepCost(n, flops, bytes);
+   }
+   else
+   {
+      radix2Cost(n, flops, bytes);
+   }
+}
+
+// This function is the same as above for any n, following the algorithm
+// the plan picked. A mixed radix pass twiddles every value (6 flops) and
+// does a 2, 3 or 5 point DFT of 4, 18 or 160 flops per group. Bluestein is
+// the chirp multiplies, two radix-2 transforms of the convolution length,
+// the pointwise product and the scaled chirp multiply at the end.
+template <typename T>
+static void fftCost(int64_t n, int64_t &flops, int64_t &bytes)
+{
+   if((n & (n-1)) == 0)
+   {
+      pow2Cost(n, flops, bytes);
+      return;
+   }
+   std::shared_ptr<const BasicFFTPlan<T> > plan = getFFTPlan<T>(n);
+   if(plan->getAlgorithm() == FFT_MIXED_RADIX)
+   {
+      const std::vector<int> &radices = plan->getRadices();
+      flops = 0;
+      bytes = 64*n;
+      for(int f=0; f<(int)radices.size(); f++)
       {
-         double theta = (2*PI*k)/n;
-         double rootReal = cos(theta);
-         double rootImag = sin(theta);
-         double evenReal = evens[k].getReal();
-         double evenImag = evens[k].getImag();
-         double oddReal = odds[k].getReal();
-         double oddImag = odds[k].getImag();
-         result[k] = Poly(evenReal+((rootReal*oddReal)+((-1)*(rootImag*oddImag))), evenImag+((rootReal*oddImag)+(rootImag*oddReal)));
-         result[k+(n/2)] = Poly(evenReal-((rootReal*oddReal)+((-1)*(rootImag*oddImag))), evenImag-((rootReal*oddImag)+(rootImag*oddReal)));
+         int p = radices[f];
+         flops += n/p*(6*p + (p == 2 ? 4 : p == 3 ? 18 : 160));
+         bytes += 48*n;
       }
-      return result;
    }
+   else
+   {
+      int64_t m = plan->getConvSize();
+      pow2Cost(m, flops, bytes);
+      flops = 2*flops + 6*n + 6*m + 8*n;
+      bytes = 2*bytes + 32*n + 16*m + 48*m + 48*n;
+   }
+}
+
+// This function transforms a polynomial of any size in place, using the
+// algorithm its cached FFTPlan picked: radix-2 for powers of two, mixed
+// radix for sizes made of 2, 3 and 5 and Bluestein's chirp-z otherwise.
+// All three are O(n log n). Powers of two up to maxCodeletSize go straight
+// to an unrolled codelet without looking up a plan.
+// Pre: polys - coefficients of a polynomial of size n > 0
+// Post: polys[k] holds the polynomial evaluated at the kth root of unity
+void fft(std::vector<Poly> &polys)
+{
+   fft(&polys[0], polys.size());
 }
 
-std::vector<Poly> fftCount(int n, std::vector<Poly> polys)
+// This function is the same as above for n coefficients in any buffer, of
+// any complex type: float and double-double values take the same path with
+// plans in their own precision
+template <typename C>
+void fft(C *polys, int n)
 {
-   if(n==1)
-      return polys;
+   typedef typename ScalarOf<C>::type T;
+   InstrumentPhase phase("transform");
+   if(phase.active())
+   {
+      int64_t flops, bytes;
+      fftCost<T>(n, flops, bytes);
+      phase.count(flops, scaledBytes<T>(bytes));
+   }
+   if(n <= maxCodeletSize && (n & (n-1)) == 0 && hasCodelets<C>())
+   {
+      codeletFFT(polys, n);
+      return;
+   }
+   std::shared_ptr<const BasicFFTPlan<T> > plan = getFFTPlan<T>(n);
+   if(plan->getAlgorithm() == FFT_RADIX2)
+   {
+      radix2FFT(polys, n, *plan);
+   }
+   else if(plan->getAlgorithm() == FFT_MIXED_RADIX)
+   {
+      mixedRadixFFT(polys, n, *plan);
+   }
    else
    {
-      std::vector<Poly> tempEvens(n/2);
-      std::vector<Poly> tempOdds(n/2);
-      std::vector<Poly> result(n);
-      int countE=0, countO=0;
-      for(int i=0; i<n; i++)
+      bluesteinFFT(polys, n, *plan);
+   }
+}
+
+// This function is the FFT of n real coefficients done as a complex FFT of
+// half the size. Packing z_j = a_2j + i*a_2j+1 and transforming gives Z,
+// from which the transforms of the even and odd coefficients are
+// E_k = (Z_k + conj(Z_h-k))/2 and O_k = (Z_k - conj(Z_h-k))/2i, h = n/2,
+// and one radix-2 step X_k = E_k + w^k*O_k, X_k+h = E_k - w^k*O_k gives
+// the full transform. Pairs k and h-k are finished together so Z is
+// consumed in place and the outputs fill the empty upper half.
+// Pre: values - room for n, n even, values[j] = a_2j + i*a_2j+1 for j < n/2
+// Post: values[k] holds the polynomial evaluated at the kth root of unity
+void realFFT(Poly *values, int n)
+{
+   int half = n/2;
+   fft(values, half);
+   std::shared_ptr<const FFTPlan> plan = getFFTPlan(n);
+   //18 flops per pair k, h-k and 10 more when they differ, reading half
+   //the values and roots and writing all n values
+   InstrumentPhase phase("untangle");
+   if(phase.active())
+   {
+      int64_t pairs = half/2;
+      phase.count(2 + 18*pairs + 10*(pairs - (half%2 == 0 ? 1 : 0)), 32*(int64_t)n);
+   }
+
+   double zReal = values[0].getReal();
+   double zImag = values[0].getImag();
+   values[0] = Poly(zReal + zImag, 0);
+   values[half] = Poly(zReal - zImag, 0);
+   for(int k=1; k<=half-k; k++)
+   {
+      int m = half-k;
+      double kReal = values[k].getReal(), kImag = values[k].getImag();
+      double mReal = values[m].getReal(), mImag = values[m].getImag();
+      //E_k and O_k, E_m and O_m are their conjugates
+      double eReal = (kReal + mReal)/2, eImag = (kImag - mImag)/2;
+      double oReal = (kImag + mImag)/2, oImag = (mReal - kReal)/2;
+      double wReal = plan->rootReal(k), wImag = plan->rootImag(k);
+      double tReal = (wReal*oReal)+((-1)*(wImag*oImag));
+      double tImag = (wReal*oImag)+(wImag*oReal);
+      values[k] = Poly(eReal + tReal, eImag + tImag);
+      values[k+half] = Poly(eReal - tReal, eImag - tImag);
+      if(m != k)
+      {
+         wReal = plan->rootReal(m);
+         wImag = plan->rootImag(m);
+         tReal = (wReal*oReal)-((-1)*(wImag*oImag));
+         tImag = (-1)*(wReal*oImag)+(wImag*oReal);
+         values[m] = Poly(eReal + tReal, (-1)*eImag + tImag);
+         values[m+half] = Poly(eReal - tReal, (-1)*eImag - tImag);
+      }
+   }
+}
+
+// This function undoes fft: with w the nth root of unity fft evaluates at,
+// a_j = (1/n) * sum over k of A_k * w^(-jk), which is the forward transform
+// of the conjugated values, conjugated back and scaled. Any n the forward
+// transform handles works.
+// Pre: values - a polynomial evaluated at all n roots of unity, n > 0
+// Post: values holds the n coefficients of that polynomial
+void inverseFFT(std::vector<Poly> &values)
+{
+   int n=values.size();
+   for(int k=0; k<n; k++)
+   {
+      values[k].setImag((-1)*values[k].getImag());
+   }
+   fft(values);
+   double scale = 1.0/n;
+   for(int j=0; j<n; j++)
+   {
+      values[j] = Poly(values[j].getReal()*scale, (-1)*values[j].getImag()*scale);
+   }
+}
+
+// This function implements an iterative radix-2 FFT that works in place on a
+// single buffer. The input is put into bit reversed order and then log2(n)
+// passes of butterflies combine neighbouring blocks of length 2, 4, ..., n,
+// which is the same work the recursive even/odd split does without allocating
+// a new vector at every level. Twiddle factors are read from the FFTPlan
+// cache instead of being recomputed. Transforms too large for the cache are
+// handed to the four-step version, large ones to the task parallel version
+// when more than one thread is configured.
+// Pre: polys - n coefficients where n is a power of two
+//      plan  - the plan for size n
+// Post: polys[k] holds the polynomial evaluated at the kth root of unity
+template <typename C>
+void radix2FFT(C *polys, int n, const PlanOf<C> &plan)
+{
+   if(n >= getFourStepThreshold())
+   {
+      fourStepFFT(polys, n, plan);
+      return;
+   }
+   if(getEvalThreads() > 1 && n >= 2*getFFTGrainSize())
+   {
+      parallelRadix2FFT(polys, n, plan);
+      return;
+   }
+
+   bitReverse(polys, n);
+   radix2Passes(polys, n, plan);
+}
+
+// This function puts n values into bit reversed order in place
+// Pre: n is a power of two
+template <typename C>
+void bitReverse(C *polys, int n)
+{
+   for(int i=1, j=0; i<n; i++)
+   {
+      int bit = n >> 1;
+      for(; j & bit; bit >>= 1)
+      {
+         j ^= bit;
+      }
+      j ^= bit;
+      if(i < j)
+      {
+         std::swap(polys[i], polys[j]);
+      }
+   }
+}
+
+// This function runs the butterfly passes of the radix-2 FFT on one block
+// that is already in bit reversed order, combining blocks of length 2, 4,
+// ..., len. A block of the full transform uses the same twiddles as a whole
+// transform of its length, so this serves as the serial leaf of the parallel
+// FFT as well. The passes up to maxCodeletSize are done by the codelets.
+// Pre: polys - len values in bit reversed order, len a power of two
+//      plan  - the plan for any power of two size >= len
+// Post: polys holds the transform of the block
+template <typename C>
+void radix2Passes(C *polys, int n, const PlanOf<C> &plan)
+{
+   typedef typename ScalarOf<C>::type T;
+   int leafLen = hasCodelets<C>() ? std::min(n, maxCodeletSize) : 1;
+   codeletBlocks(polys, n, leafLen);
+
+   //remaining butterfly passes, twiddles come from the cached plan for this size
+   for(int len=2*leafLen; len<=n; len <<= 1)
+   {
+      int half = len/2;
+      const T *twiddleReal = plan.twiddleReal(len);
+      const T *twiddleImag = plan.twiddleImag(len);
+      for(int start=0; start<n; start+=len)
       {
-         if(i%2 == 0)
+         for(int k=0; k<half; k++)
          {
-            tempEvens.at(countE) = polys[i];
-            countE++;
+            T rootReal = twiddleReal[k];
+            T rootImag = twiddleImag[k];
+            T evenReal = polys[start+k].getReal();
+            T evenImag = polys[start+k].getImag();
+            T oddReal = polys[start+k+half].getReal();
+            T oddImag = polys[start+k+half].getImag();
+            T tReal = (rootReal*oddReal)+((-1)*(rootImag*oddImag));
+            T tImag = (rootReal*oddImag)+(rootImag*oddReal);
+            polys[start+k] = C(evenReal+tReal, evenImag+tImag);
+            polys[start+k+half] = C(evenReal-tReal, evenImag-tImag);
          }
-         else
+      }
+   }
+}
+
+// This function implements a mixed radix FFT for sizes whose only prime
+// factors are 2, 3 and 5. It is the radix-2 algorithm generalised: the input
+// is put into digit reversed order and each pass combines p blocks of length
+// subLen into one of length p*subLen with a p-point butterfly.
+// Pre: polys - n coefficients, n made of the factors 2, 3 and 5
+//      plan  - the plan for size n
+// Post: polys[k] holds the polynomial evaluated at the kth root of unity
+template <typename C>
+void mixedRadixFFT(C *polys, int n, const PlanOf<C> &plan)
+{
+   typedef typename ScalarOf<C>::type T;
+   WorkspaceFrame frame;
+   C *scratch = frame.allocate<C>(n);
+   std::copy(polys, polys+n, scratch);
+   const int *digitReversal = plan.getDigitReversal();
+   for(int i=0; i<n; i++)
+   {
+      polys[i] = scratch[digitReversal[i]];
+   }
+
+   const std::vector<int> &radices = plan.getRadices();
+   int subLen = 1;
+   for(int f=radices.size()-1; f>=0; f--)
+   {
+      int p = radices[f];
+      int len = p*subLen;
+      int rootStride = n/len;
+      for(int start=0; start<n; start+=len)
+      {
+         for(int k=0; k<subLen; k++)
          {
-            tempOdds.at(countO) = polys[i];
-            countO++;
+            //apply the twiddles w_len^(r*k) to the p inputs
+            T xReal[5], xImag[5];
+            for(int r=0; r<p; r++)
+            {
+               int idx = rootStride*r*k;
+               T vReal = polys[start+r*subLen+k].getReal();
+               T vImag = polys[start+r*subLen+k].getImag();
+               xReal[r] = (vReal*plan.rootReal(idx)) + ((-1)*vImag*plan.rootImag(idx));
+               xImag[r] = (vReal*plan.rootImag(idx)) + (vImag*plan.rootReal(idx));
+            }
+
+            //p-point DFT of the twiddled inputs
+            if(p == 2)
+            {
+               polys[start+k] = C(xReal[0]+xReal[1], xImag[0]+xImag[1]);
+               polys[start+subLen+k] = C(xReal[0]-xReal[1], xImag[0]-xImag[1]);
+            }
+            else if(p == 3)
+            {
+               //sin(2*PI/3), taken from the plan's roots like every other twiddle
+               T sinThird = plan.rootImag(n/3);
+               T sumReal = xReal[1]+xReal[2];
+               T sumImag = xImag[1]+xImag[2];
+               T diffReal = xReal[1]-xReal[2];
+               T diffImag = xImag[1]-xImag[2];
+               T midReal = xReal[0] - 0.5*sumReal;
+               T midImag = xImag[0] - 0.5*sumImag;
+               polys[start+k] = C(xReal[0]+sumReal, xImag[0]+sumImag);
+               polys[start+subLen+k] = C(midReal - sinThird*diffImag, midImag + sinThird*diffReal);
+               polys[start+2*subLen+k] = C(midReal + sinThird*diffImag, midImag - sinThird*diffReal);
+            }
+            else
+            {
+               int pStride = n/p;
+               for(int q=0; q<p; q++)
+               {
+                  T sumReal = xReal[0];
+                  T sumImag = xImag[0];
+                  for(int r=1; r<p; r++)
+                  {
+                     int idx = pStride*((r*q)%p);
+                     sumReal += (xReal[r]*plan.rootReal(idx)) + ((-1)*xImag[r]*plan.rootImag(idx));
+                     sumImag += (xReal[r]*plan.rootImag(idx)) + (xImag[r]*plan.rootReal(idx));
+                  }
+                  polys[start+q*subLen+k] = C(sumReal, sumImag);
+               }
+            }
          }
       }
+      subLen = len;
+   }
+}
 
-      std::vector<Poly> evens = fftCount(n/2, tempEvens);
-      std::vector<Poly> odds  = fftCount(n/2, tempOdds);
-      
-      for(int k=0; k<(n/2); k++)
+// This function implements Bluestein's chirp-z algorithm for sizes with a
+// prime factor larger than 5. Writing jk = (j^2 + k^2 - (k-j)^2)/2 turns the
+// DFT into a convolution with a chirp, which is done with power of two FFTs
+// of at least 2n-1 points: the kernel's transform is kept in the plan and the
+// inverse transform is a forward one on conjugated data.
+// Pre: polys - n coefficients
+//      plan  - the plan for size n
+// Post: polys[k] holds the polynomial evaluated at the kth root of unity
+template <typename C>
+void bluesteinFFT(C *polys, int n, const PlanOf<C> &plan)
+{
+   typedef typename ScalarOf<C>::type T;
+   int m = plan.getConvSize();
+   const PlanOf<C> &convPlan = plan.getConvPlan();
+   WorkspaceFrame frame;
+   C *scratch = frame.allocate<C>(m);
+   for(int j=0; j<n; j++)
+   {
+      T xReal = polys[j].getReal();
+      T xImag = polys[j].getImag();
+      T cReal = plan.chirpReal(j);
+      T cImag = plan.chirpImag(j);
+      scratch[j] = C((xReal*cReal) + ((-1)*xImag*cImag), (xReal*cImag) + (xImag*cReal));
+   }
+   for(int j=n; j<m; j++)
+   {
+      scratch[j] = C(0, 0);
+   }
+
+   radix2FFT(scratch, m, convPlan);
+
+   //pointwise product with the kernel, conjugated for the inverse transform
+   for(int k=0; k<m; k++)
+   {
+      T aReal = scratch[k].getReal();
+      T aImag = scratch[k].getImag();
+      T bReal = plan.kernelReal(k);
+      T bImag = plan.kernelImag(k);
+      scratch[k] = C((aReal*bReal) + ((-1)*aImag*bImag), (-1)*((aReal*bImag) + (aImag*bReal)));
+   }
+
+   radix2FFT(scratch, m, convPlan);
+
+   for(int k=0; k<n; k++)
+   {
+      T vReal = scratch[k].getReal()/m;
+      T vImag = (-1)*scratch[k].getImag()/m;
+      T cReal = plan.chirpReal(k);
+      T cImag = plan.chirpImag(k);
+      polys[k] = C((vReal*cReal) + ((-1)*vImag*cImag), (vReal*cImag) + (vImag*cReal));
+   }
+}
+
+// This function runs the evaluation algorithm picked by alg, so callers that
+// choose the algorithm at runtime (the benchmark, the command line) share
+// one switch
+// Pre: A vector of polynomials to evaluate at each of the roots of unity
+//      result - a vector to store the results in
+// Post: All nth roots of unity have been computed with the chosen algorithm
+// Throws: -1 if no polynomial exists yet
+int runEvaluation(EvalAlgorithm alg, std::vector<Poly> &polys, std::vector<Poly> &result)
+{
+   result.resize(polys.size());
+   if(alg == ALG_NAIVE)
+   {
+      return naivePolyEval(polys, result);
+   }
+   else if(alg == ALG_HORNER)
+   {
+      return hornerEval(polys, result);
+   }
+   else if(alg == ALG_HORNER_SIMD)
+   {
+      return hornerEvalSIMD(polys, result);
+   }
+   else if(alg == ALG_REPEATED_SQUARING)
+   {
+      return repeatedSquaringEval(polys, result);
+   }
+   else
+   {
+      return callFFT(polys, result);
+   }
+}
+
+static const char *algorithmNames[] = {"naive", "horner", "horner-simd", "squaring", "fft"};
+
+// This function returns the short name of an algorithm
+const char* algorithmName(EvalAlgorithm alg)
+{
+   return algorithmNames[alg];
+}
+
+// This function looks an algorithm up by its short name
+// Post: alg is set when the name is known
+// Throws: -1 if the name is not an algorithm
+int parseAlgorithm(const std::string &name, EvalAlgorithm &alg)
+{
+   for(int i=0; i<ALG_COUNT; i++)
+   {
+      if(name == algorithmNames[i])
       {
-         double theta = (2*PI*k)/n;
-         double rootReal = cos(theta);
-         double rootImag = sin(theta);
-         double evenReal = evens[k].getReal();
-         double evenImag = evens[k].getImag();
-         double oddReal = odds[k].getReal();
-         double oddImag = odds[k].getImag();
-         /*if(oddImag==0 && rootImag==0) {}
-         else
-            globalCount+=2;*/
-         if(round(oddImag)!=0 || round(rootImag)!=0)
-            globalCount+=2;
-         result[k] = Poly(evenReal+((rootReal*oddReal)+((-1)*(rootImag*oddImag))), evenImag+((rootReal*oddImag)+(rootImag*oddReal)));
-         result[k+(n/2)] = Poly(evenReal-((rootReal*oddReal)+((-1)*(rootImag*oddImag))), evenImag-((rootReal*oddImag)+(rootImag*oddReal)));
+         alg = (EvalAlgorithm)i;
+         return 0;
       }
-      return result;
    }
+   return -1;
 }
+
+template int naivePolyEval<float>(const float*, const float*, int, float*, float*);
+template int naivePolyEval<DoubleDouble>(const DoubleDouble*, const DoubleDouble*, int, DoubleDouble*, DoubleDouble*);
+template int hornerEval<float>(const float*, const float*, int, float*, float*);
+template int hornerEval<DoubleDouble>(const DoubleDouble*, const DoubleDouble*, int, DoubleDouble*, DoubleDouble*);
+template int repeatedSquaringEval<float>(const float*, const float*, int, float*, float*);
+template int repeatedSquaringEval<DoubleDouble>(const DoubleDouble*, const DoubleDouble*, int, DoubleDouble*, DoubleDouble*);
+template void hornerEvalAt<double>(const double*, const double*, int, const double*, const double*, int, double*, double*);
+template void genExponentsNaive<Poly>(Poly, int, double*, double*);
+template void repeatedSquaringExp<Poly>(Poly, int, double*, double*);
+
+template void fft<Poly>(Poly*, int);
+template void fft<ScalarComplex<float> >(ScalarComplex<float>*, int);
+template void fft<ScalarComplex<DoubleDouble> >(ScalarComplex<DoubleDouble>*, int);
+template void radix2FFT<Poly>(Poly*, int, const FFTPlan&);
+template void radix2FFT<ScalarComplex<float> >(ScalarComplex<float>*, int, const BasicFFTPlan<float>&);
+template void radix2FFT<ScalarComplex<DoubleDouble> >(ScalarComplex<DoubleDouble>*, int, const BasicFFTPlan<DoubleDouble>&);
+template void radix2Passes<Poly>(Poly*, int, const FFTPlan&);
+template void radix2Passes<ScalarComplex<float> >(ScalarComplex<float>*, int, const BasicFFTPlan<float>&);
+template void radix2Passes<ScalarComplex<DoubleDouble> >(ScalarComplex<DoubleDouble>*, int, const BasicFFTPlan<DoubleDouble>&);
+template void bitReverse<Poly>(Poly*, int);
+template void bitReverse<ScalarComplex<float> >(ScalarComplex<float>*, int);
+template void bitReverse<ScalarComplex<DoubleDouble> >(ScalarComplex<DoubleDouble>*, int);
@@ -1,18 +1,84 @@
+#ifndef ALGIMPL_H
+#define ALGIMPL_H
 #include "genPolys.h"
+#include "FFTPlan.h"
+#include "PolySoA.h"
+#include "PolyBatch.h"
+#include "ThreadPool.h"
+#include "Workspace.h"
+#include "Instrumentation.h"
 #include <math.h>
 #include <vector>
+#include <algorithm>
 int naivePolyEval(std::vector<Poly>&, std::vector<Poly>&);
-int naivePolyEvalCounts(std::vector<Poly> &polys, int64_t&);
+int naivePolyEval(const PolySoA&, PolySoA&);
+int naivePolyEval(const double*, const double*, int, PolySoA&);
+template <typename T> int naivePolyEval(const T*, const T*, int, T*, T*);
 void genExponents(Poly base, int n, std::vector<Poly> &result);
 void genExponentsNaive(Poly,int,std::vector<Poly>&);
-void genExponentsNaiveCounts(Poly,int,std::vector<Poly>&, int64_t&);
+void genExponentsNaive(Poly,int,PolySoA&);
+template <typename C> void genExponentsNaive(C, int, typename ScalarOf<C>::type*, typename ScalarOf<C>::type*);
 int hornerEval(std::vector<Poly>&, std::vector<Poly>&);
-int hornerEvalCounts(std::vector<Poly> &polys, int&);
+int hornerEval(const PolySoA&, PolySoA&);
+int hornerEval(const double*, const double*, int, PolySoA&);
+template <typename T> int hornerEval(const T*, const T*, int, T*, T*);
+template <typename T> void hornerEvalAt(const T*, const T*, int, const T*, const T*, int, T*, T*);
+enum SimdLevel { SIMD_SCALAR, SIMD_AVX2, SIMD_AVX512 };
+SimdLevel detectSimdLevel();
+int hornerEvalSIMD(std::vector<Poly>&, std::vector<Poly>&);
+int hornerEvalSIMD(const PolySoA&, PolySoA&);
+int hornerEvalSIMD(const PolySoA&, PolySoA&, SimdLevel);
+int hornerEvalSIMD(const double*, const double*, int, PolySoA&, SimdLevel);
 int repeatedSquaringEval(std::vector<Poly>&, std::vector<Poly>&);
-int repeatedSquaringEvalCounts(std::vector<Poly>&, int64_t&);
+int repeatedSquaringEval(const PolySoA&, PolySoA&);
+int repeatedSquaringEval(const double*, const double*, int, PolySoA&);
+template <typename T> int repeatedSquaringEval(const T*, const T*, int, T*, T*);
 void repeatedSquaringExp(Poly base, int n, std::vector<Poly>&);
-void repeatedSquaringExpCounts(Poly base, int n, std::vector<Poly>&, int64_t&);
-std::vector<Poly> fft(int, std::vector<Poly>);
-std::vector<Poly> fftCount(int, std::vector<Poly>);
+void repeatedSquaringExp(Poly base, int n, PolySoA&);
+template <typename C> void repeatedSquaringExp(C, int, typename ScalarOf<C>::type*, typename ScalarOf<C>::type*);
+void fft(std::vector<Poly>&);
+template <typename C> void fft(C*, int);
+void realFFT(Poly*, int);
+bool isRealPoly(const Poly*, int);
+void inverseFFT(std::vector<Poly>&);
+template <typename C> void radix2FFT(C*, int, const PlanOf<C>&);
+template <typename C> void radix2Passes(C*, int, const PlanOf<C>&);
+template <typename C> void bitReverse(C*, int);
+template <typename C> void parallelRadix2FFT(C*, int, const PlanOf<C>&);
+void setFFTGrainSize(int);
+int getFFTGrainSize();
+template <typename C> void fourStepFFT(C*, int, const PlanOf<C>&);
+void setFourStepThreshold(int);
+int getFourStepThreshold();
+const int maxCodeletSize = 64;
+// The codelets' twiddles are rounded to double at compile time, transforms
+// in double-double take every pass from the plan instead
+template <typename C> bool hasCodelets() { return sizeof(typename ScalarOf<C>::type) <= sizeof(double); }
+template <typename C> void codeletFFT(C*, int);
+template <typename C> void codeletBlocks(C*, int, int);
+template <> void codeletFFT(ScalarComplex<DoubleDouble>*, int);
+template <> void codeletBlocks(ScalarComplex<DoubleDouble>*, int, int);
+template <typename C> void mixedRadixFFT(C*, int, const PlanOf<C>&);
+template <typename C> void bluesteinFFT(C*, int, const PlanOf<C>&);
 int callFFT(std::vector<Poly>&, std::vector<Poly>&);
-int callFFTCount(std::vector<Poly>&, int&);
+int callFFT(const Poly*, int, std::vector<Poly>&);
+int callFFT(const PolySoA&, PolySoA&);
+void sparseDFT(const int*, const double*, const double*, int, const FFTPlan&, double*, double*);
+int sparseTermLimit(int);
+int callInverseFFT(std::vector<Poly>&, std::vector<Poly>&);
+int callFFTBatch(const PolyBatch&, PolyBatch&);
+int multiply(const std::vector<Poly>&, const std::vector<Poly>&, std::vector<Poly>&);
+void schoolbookMultiply(const Poly*, int, const Poly*, int, Poly*);
+void fftMultiply(const Poly*, int, const Poly*, int, Poly*);
+int convolutionSize(int);
+int tuneMultiplyCrossover(bool);
+void setMultiplyCrossover(int, bool);
+int getMultiplyCrossover(bool);
+int evalAtPoints(const std::vector<Poly>&, const std::vector<Poly>&, std::vector<Poly>&);
+int hornerEvalAt(const std::vector<Poly>&, const std::vector<Poly>&, std::vector<Poly>&);
+enum EvalAlgorithm { ALG_NAIVE, ALG_HORNER, ALG_HORNER_SIMD, ALG_REPEATED_SQUARING, ALG_FFT, ALG_COUNT };
+int runEvaluation(EvalAlgorithm, std::vector<Poly>&, std::vector<Poly>&);
+int instrumentEvaluation(EvalAlgorithm, std::vector<Poly>&, std::vector<Poly>&, bool, InstrumentReport&);
+const char* algorithmName(EvalAlgorithm);
+int parseAlgorithm(const std::string&, EvalAlgorithm&);
+#endif
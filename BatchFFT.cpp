@@ -0,0 +1,284 @@
+#include "AlgImpl.h"
+
+// Batched FFT. Every kernel below works on the columns bBegin..bEnd-1 of a
+// row major matrix (row j, column b at j*stride + b) and runs the same
+// algorithm as its single polynomial counterpart, with the innermost loop
+// over the columns of a row so it streams through memory and vectorizes.
+
+// This function is the batched radix-2 FFT: the rows are put into bit
+// reversed order and the butterfly passes run across the columns
+static void batchRadix2(double *re, double *im, int n, int stride, int bBegin, int bEnd, const FFTPlan &plan)
+{
+   for(int i=1, j=0; i<n; i++)
+   {
+      int bit = n >> 1;
+      for(; j & bit; bit >>= 1)
+      {
+         j ^= bit;
+      }
+      j ^= bit;
+      if(i < j)
+      {
+         std::swap_ranges(re+(size_t)i*stride+bBegin, re+(size_t)i*stride+bEnd, re+(size_t)j*stride+bBegin);
+         std::swap_ranges(im+(size_t)i*stride+bBegin, im+(size_t)i*stride+bEnd, im+(size_t)j*stride+bBegin);
+      }
+   }
+
+   for(int len=2; len<=n; len <<= 1)
+   {
+      int half = len/2;
+      const double *twiddleReal = plan.twiddleReal(len);
+      const double *twiddleImag = plan.twiddleImag(len);
+      for(int start=0; start<n; start+=len)
+      {
+         for(int k=0; k<half; k++)
+         {
+            double rootReal = twiddleReal[k];
+            double rootImag = twiddleImag[k];
+            double *__restrict__ evenRe = re+(size_t)(start+k)*stride;
+            double *__restrict__ evenIm = im+(size_t)(start+k)*stride;
+            double *__restrict__ oddRe = re+(size_t)(start+k+half)*stride;
+            double *__restrict__ oddIm = im+(size_t)(start+k+half)*stride;
+            for(int b=bBegin; b<bEnd; b++)
+            {
+               double tReal = (rootReal*oddRe[b])+((-1)*(rootImag*oddIm[b]));
+               double tImag = (rootReal*oddIm[b])+(rootImag*oddRe[b]);
+               double evenReal = evenRe[b];
+               double evenImag = evenIm[b];
+               evenRe[b] = evenReal+tReal;
+               evenIm[b] = evenImag+tImag;
+               oddRe[b] = evenReal-tReal;
+               oddIm[b] = evenImag-tImag;
+            }
+         }
+      }
+   }
+}
+
+// This function is the batched mixed radix FFT for sizes made of 2, 3 and 5:
+// rows are gathered in digit reversed order and each pass twiddles and
+// combines p rows at a time
+static void batchMixedRadix(double *re, double *im, int n, int stride, int bBegin, int bEnd, const FFTPlan &plan)
+{
+   int width = bEnd-bBegin;
+   WorkspaceFrame frame;
+   double *copyRe = frame.allocate<double>((size_t)n*width);
+   double *copyIm = frame.allocate<double>((size_t)n*width);
+   for(int i=0; i<n; i++)
+   {
+      std::copy(re+(size_t)i*stride+bBegin, re+(size_t)i*stride+bEnd, copyRe+(size_t)i*width);
+      std::copy(im+(size_t)i*stride+bBegin, im+(size_t)i*stride+bEnd, copyIm+(size_t)i*width);
+   }
+   const int *digitReversal = plan.getDigitReversal();
+   for(int i=0; i<n; i++)
+   {
+      std::copy(copyRe+(size_t)digitReversal[i]*width, copyRe+(size_t)(digitReversal[i]+1)*width, re+(size_t)i*stride+bBegin);
+      std::copy(copyIm+(size_t)digitReversal[i]*width, copyIm+(size_t)(digitReversal[i]+1)*width, im+(size_t)i*stride+bBegin);
+   }
+
+   const std::vector<int> &radices = plan.getRadices();
+   int subLen = 1;
+   for(int f=radices.size()-1; f>=0; f--)
+   {
+      int p = radices[f];
+      int len = p*subLen;
+      int rootStride = n/len;
+      //w_p^q for the p-point DFT
+      double wReal[5], wImag[5];
+      for(int q=0; q<p; q++)
+      {
+         wReal[q] = plan.rootReal((n/p)*q);
+         wImag[q] = plan.rootImag((n/p)*q);
+      }
+      for(int start=0; start<n; start+=len)
+      {
+         for(int k=0; k<subLen; k++)
+         {
+            double *rowRe[5], *rowIm[5];
+            for(int r=0; r<p; r++)
+            {
+               rowRe[r] = re+(size_t)(start+r*subLen+k)*stride;
+               rowIm[r] = im+(size_t)(start+r*subLen+k)*stride;
+            }
+            //twiddle rows 1..p-1 by w_len^(r*k) in place, row 0 has w = 1
+            for(int r=1; r<p; r++)
+            {
+               int idx = rootStride*r*k;
+               double tr = plan.rootReal(idx);
+               double ti = plan.rootImag(idx);
+               double *__restrict__ vRe = rowRe[r];
+               double *__restrict__ vIm = rowIm[r];
+               for(int b=bBegin; b<bEnd; b++)
+               {
+                  double vReal = vRe[b];
+                  vRe[b] = (vReal*tr) + ((-1)*vIm[b]*ti);
+                  vIm[b] = (vReal*ti) + (vIm[b]*tr);
+               }
+            }
+
+            if(p == 2)
+            {
+               for(int b=bBegin; b<bEnd; b++)
+               {
+                  double aReal = rowRe[0][b], aImag = rowIm[0][b];
+                  double cReal = rowRe[1][b], cImag = rowIm[1][b];
+                  rowRe[0][b] = aReal+cReal;
+                  rowIm[0][b] = aImag+cImag;
+                  rowRe[1][b] = aReal-cReal;
+                  rowIm[1][b] = aImag-cImag;
+               }
+            }
+            else if(p == 3)
+            {
+               double sinThird = wImag[1];
+               for(int b=bBegin; b<bEnd; b++)
+               {
+                  double sumReal = rowRe[1][b]+rowRe[2][b];
+                  double sumImag = rowIm[1][b]+rowIm[2][b];
+                  double diffReal = rowRe[1][b]-rowRe[2][b];
+                  double diffImag = rowIm[1][b]-rowIm[2][b];
+                  double midReal = rowRe[0][b] - 0.5*sumReal;
+                  double midImag = rowIm[0][b] - 0.5*sumImag;
+                  rowRe[0][b] += sumReal;
+                  rowIm[0][b] += sumImag;
+                  rowRe[1][b] = midReal - sinThird*diffImag;
+                  rowIm[1][b] = midImag + sinThird*diffReal;
+                  rowRe[2][b] = midReal + sinThird*diffImag;
+                  rowIm[2][b] = midImag - sinThird*diffReal;
+               }
+            }
+            else
+            {
+               for(int b=bBegin; b<bEnd; b++)
+               {
+                  double xReal[5], xImag[5];
+                  for(int r=0; r<p; r++)
+                  {
+                     xReal[r] = rowRe[r][b];
+                     xImag[r] = rowIm[r][b];
+                  }
+                  for(int q=0; q<p; q++)
+                  {
+                     double sumReal = xReal[0];
+                     double sumImag = xImag[0];
+                     for(int r=1; r<p; r++)
+                     {
+                        int w = (r*q)%p;
+                        sumReal += (xReal[r]*wReal[w]) + ((-1)*xImag[r]*wImag[w]);
+                        sumImag += (xReal[r]*wImag[w]) + (xImag[r]*wReal[w]);
+                     }
+                     rowRe[q][b] = sumReal;
+                     rowIm[q][b] = sumImag;
+                  }
+               }
+            }
+         }
+      }
+      subLen = len;
+   }
+}
+
+// This function is the batched Bluestein FFT: chirp, batched power of two
+// convolution with the plan's kernel, chirp again, all row by row
+static void batchBluestein(double *re, double *im, int n, int stride, int bBegin, int bEnd, const FFTPlan &plan)
+{
+   int m = plan.getConvSize();
+   int width = bEnd-bBegin;
+   WorkspaceFrame frame;
+   double *convRe = frame.allocate<double>((size_t)m*width);
+   double *convIm = frame.allocate<double>((size_t)m*width);
+   for(int j=0; j<n; j++)
+   {
+      double cReal = plan.chirpReal(j);
+      double cImag = plan.chirpImag(j);
+      const double *xRe = re+(size_t)j*stride+bBegin;
+      const double *xIm = im+(size_t)j*stride+bBegin;
+      double *__restrict__ aRe = convRe+(size_t)j*width;
+      double *__restrict__ aIm = convIm+(size_t)j*width;
+      for(int b=0; b<width; b++)
+      {
+         aRe[b] = (xRe[b]*cReal) + ((-1)*xIm[b]*cImag);
+         aIm[b] = (xRe[b]*cImag) + (xIm[b]*cReal);
+      }
+   }
+   std::fill(convRe+(size_t)n*width, convRe+(size_t)m*width, 0.0);
+   std::fill(convIm+(size_t)n*width, convIm+(size_t)m*width, 0.0);
+
+   batchRadix2(convRe, convIm, m, width, 0, width, plan.getConvPlan());
+
+   //pointwise product with the kernel, conjugated for the inverse transform
+   for(int k=0; k<m; k++)
+   {
+      double bReal = plan.kernelReal(k);
+      double bImag = plan.kernelImag(k);
+      double *__restrict__ aRe = convRe+(size_t)k*width;
+      double *__restrict__ aIm = convIm+(size_t)k*width;
+      for(int b=0; b<width; b++)
+      {
+         double aReal = aRe[b];
+         aRe[b] = (aReal*bReal) + ((-1)*aIm[b]*bImag);
+         aIm[b] = (-1)*((aReal*bImag) + (aIm[b]*bReal));
+      }
+   }
+
+   batchRadix2(convRe, convIm, m, width, 0, width, plan.getConvPlan());
+
+   for(int k=0; k<n; k++)
+   {
+      double cReal = plan.chirpReal(k);
+      double cImag = plan.chirpImag(k);
+      const double *vRe = convRe+(size_t)k*width;
+      const double *vIm = convIm+(size_t)k*width;
+      double *__restrict__ xRe = re+(size_t)k*stride+bBegin;
+      double *__restrict__ xIm = im+(size_t)k*stride+bBegin;
+      for(int b=0; b<width; b++)
+      {
+         double vReal = vRe[b]/m;
+         double vImag = (-1)*vIm[b]/m;
+         xRe[b] = (vReal*cReal) + ((-1)*vImag*cImag);
+         xIm[b] = (vReal*cImag) + (vImag*cReal);
+      }
+   }
+}
+
+// This function evaluates every polynomial of a batch at all nth roots of
+// unity. One plan serves the whole batch, and the columns are split across
+// the evaluation threads in slices of whole cache lines.
+// Pre: polys - B polynomials of size n
+//      result - resized to hold the B results
+// Post: result column b, row k holds polynomial b evaluated at the kth root
+// Throws: -1 if the batch is empty
+int callFFTBatch(const PolyBatch &polys, PolyBatch &result)
+{
+   int n = polys.size();
+   int batch = polys.batchSize();
+   if(n==0 || batch==0)
+   {
+      return -1;
+   }
+   result = polys;
+   std::shared_ptr<const FFTPlan> plan = getFFTPlan(n);
+   double *re = result.realData();
+   double *im = result.imagData();
+   //8 doubles to a 64 byte cache line
+   const int lineWidth = 8;
+   int lines = (batch+lineWidth-1)/lineWidth;
+   parallelFor(0, lines, [&](int lineBegin, int lineEnd)
+   {
+      int bBegin = lineBegin*lineWidth;
+      int bEnd = std::min(batch, lineEnd*lineWidth);
+      if(plan->getAlgorithm() == FFT_RADIX2)
+      {
+         batchRadix2(re, im, n, batch, bBegin, bEnd, *plan);
+      }
+      else if(plan->getAlgorithm() == FFT_MIXED_RADIX)
+      {
+         batchMixedRadix(re, im, n, batch, bBegin, bEnd, *plan);
+      }
+      else
+      {
+         batchBluestein(re, im, n, batch, bBegin, bEnd, *plan);
+      }
+   });
+   return 0;
+}
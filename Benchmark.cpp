@@ -0,0 +1,136 @@
+#include "Benchmark.h"
+#include <chrono>
+
+// This function returns the number of real floating point operations an
+// algorithm spends on a polynomial of size n, the work the GFLOP/s figures
+// are based on. A complex multiply counts 6, a complex multiply-add 8 and the
+// FFT uses the customary 5 n log2(n).
+double algorithmFlops(EvalAlgorithm alg, int n)
+{
+   double N = n;
+   if(alg == ALG_NAIVE)
+   {
+      //x^i built with i multiplies for i < n, then the n-1 term sum
+      return N*(6.0*N*(N-1)/2 + 8.0*(N-1));
+   }
+   else if(alg == ALG_HORNER || alg == ALG_HORNER_SIMD)
+   {
+      return N*8.0*(N-1);
+   }
+   else if(alg == ALG_REPEATED_SQUARING)
+   {
+      //one squaring, then x^i from x^2 (i even) or x (i odd) in about i/2 steps
+      double multiplies = 1;
+      for(int i=3; i<n; i++)
+      {
+         multiplies += (i%2 == 0) ? (i/2)-1 : (i-1)/2;
+      }
+      return N*(6.0*multiplies + 8.0*(N-1));
+   }
+   else
+   {
+      return n > 1 ? 5.0*N*log2(N) : 0;
+   }
+}
+
+// This function times an algorithm on a polynomial: warmups untimed runs to
+// settle caches, plans and scratch buffers, then reps timed runs measured
+// with a monotonic wall clock
+// Pre: polys - the polynomial to evaluate, warmups >= 0, reps >= 1
+//      result - holds the evaluation of the last run afterwards
+// Post: out holds the median, 99th percentile, min, mean and standard
+//       deviation of the run times and the derived ns/point and GFLOP/s
+// Throws: -1 if no polynomial exists yet
+int benchmarkAlgorithm(EvalAlgorithm alg, std::vector<Poly> &polys, std::vector<Poly> &result, int warmups, int reps, BenchResult &out)
+{
+   if(polys.size()==0)
+   {
+      return -1;
+   }
+   return benchmarkRuns(alg, polys.size(), [&]() { runEvaluation(alg, polys, result); }, warmups, reps, out);
+}
+
+// This function is the timing loop behind benchmarkAlgorithm for any way of
+// running alg on a polynomial of size n, e.g. on a mapped file
+// Pre: run - evaluates the polynomial once, warmups >= 0, reps >= 1
+// Post: out holds the statistics of the timed runs
+int benchmarkRuns(EvalAlgorithm alg, int n, const std::function<void()> &run, int warmups, int reps, BenchResult &out)
+{
+   for(int i=0; i<warmups; i++)
+   {
+      run();
+   }
+
+   std::vector<double> times(reps);
+   for(int i=0; i<reps; i++)
+   {
+      std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+      run();
+      std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+      times[i] = std::chrono::duration<double, std::nano>(end-begin).count();
+   }
+   std::sort(times.begin(), times.end());
+
+   double sum = 0;
+   for(int i=0; i<reps; i++)
+   {
+      sum += times[i];
+   }
+   double mean = sum/reps;
+   double squares = 0;
+   for(int i=0; i<reps; i++)
+   {
+      squares += (times[i]-mean)*(times[i]-mean);
+   }
+
+   out.alg = alg;
+   out.name = algorithmName(alg);
+   out.n = n;
+   out.threads = getEvalThreads();
+   out.reps = reps;
+   out.medianNs = reps%2 == 1 ? times[reps/2] : (times[reps/2-1]+times[reps/2])/2;
+   out.p99Ns = times[std::min(reps-1, (int)ceil(0.99*reps)-1)];
+   out.minNs = times[0];
+   out.meanNs = mean;
+   out.stddevNs = reps > 1 ? sqrt(squares/(reps-1)) : 0;
+   out.nsPerPoint = out.medianNs/n;
+   out.gflops = algorithmFlops(alg, n)/out.medianNs;
+   return 0;
+}
+
+// This function is the same as above when the evaluation itself is not needed
+int benchmarkAlgorithm(EvalAlgorithm alg, std::vector<Poly> &polys, int warmups, int reps, BenchResult &out)
+{
+   std::vector<Poly> result;
+   return benchmarkAlgorithm(alg, polys, result, warmups, reps, out);
+}
+
+// This function writes results as CSV with a header line
+void writeBenchCSV(std::ostream &out, const std::vector<BenchResult> &results)
+{
+   out << "algorithm,n,threads,reps,median_ns,p99_ns,min_ns,mean_ns,stddev_ns,ns_per_point,gflops\n";
+   for(int i=0; i<(int)results.size(); i++)
+   {
+      const BenchResult &r = results[i];
+      out << r.name << "," << r.n << "," << r.threads << "," << r.reps << ","
+          << r.medianNs << "," << r.p99Ns << "," << r.minNs << "," << r.meanNs << ","
+          << r.stddevNs << "," << r.nsPerPoint << "," << r.gflops << "\n";
+   }
+}
+
+// This function writes results as a JSON array of objects
+void writeBenchJSON(std::ostream &out, const std::vector<BenchResult> &results)
+{
+   out << "[\n";
+   for(int i=0; i<(int)results.size(); i++)
+   {
+      const BenchResult &r = results[i];
+      out << "  {\"algorithm\": \"" << r.name << "\", \"n\": " << r.n
+          << ", \"threads\": " << r.threads << ", \"reps\": " << r.reps
+          << ", \"median_ns\": " << r.medianNs << ", \"p99_ns\": " << r.p99Ns
+          << ", \"min_ns\": " << r.minNs << ", \"mean_ns\": " << r.meanNs
+          << ", \"stddev_ns\": " << r.stddevNs << ", \"ns_per_point\": " << r.nsPerPoint
+          << ", \"gflops\": " << r.gflops << "}" << (i+1 < (int)results.size() ? "," : "") << "\n";
+   }
+   out << "]\n";
+}
@@ -0,0 +1,32 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include "AlgImpl.h"
+#include <ostream>
+#include <functional>
+#include <string>
+
+// Timing statistics of one algorithm on one polynomial size, all times are
+// wall clock nanoseconds per evaluation
+struct BenchResult
+{
+   EvalAlgorithm alg;
+   std::string name;
+   int n;
+   int threads;
+   int reps;
+   double medianNs;
+   double p99Ns;
+   double minNs;
+   double meanNs;
+   double stddevNs;
+   double nsPerPoint;
+   double gflops;
+};
+
+double algorithmFlops(EvalAlgorithm alg, int n);
+int benchmarkAlgorithm(EvalAlgorithm alg, std::vector<Poly> &polys, std::vector<Poly> &result, int warmups, int reps, BenchResult &out);
+int benchmarkAlgorithm(EvalAlgorithm alg, std::vector<Poly> &polys, int warmups, int reps, BenchResult &out);
+int benchmarkRuns(EvalAlgorithm alg, int n, const std::function<void()> &run, int warmups, int reps, BenchResult &out);
+void writeBenchCSV(std::ostream &out, const std::vector<BenchResult> &results);
+void writeBenchJSON(std::ostream &out, const std::vector<BenchResult> &results);
+#endif
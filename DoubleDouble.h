@@ -0,0 +1,96 @@
+#ifndef DOUBLEDOUBLE_H
+#define DOUBLEDOUBLE_H
+
+// A double-double number: the unevaluated sum hi + lo of two doubles with
+// |lo| <= ulp(hi)/2, which carries about 32 significant digits. The
+// operations are built from the error free transformations of Knuth
+// (twoSum) and Dekker (twoProduct), as in the QD library, and use no fma so
+// they give the same results without any special compiler flags.
+struct DoubleDouble
+{
+   double hi;
+   double lo;
+   DoubleDouble() : hi(0), lo(0) {}
+   DoubleDouble(double x) : hi(x), lo(0) {}
+   DoubleDouble(double hi, double lo) : hi(hi), lo(lo) {}
+};
+
+// a + b exactly as a rounded sum and its error
+inline DoubleDouble twoSum(double a, double b)
+{
+   double s = a + b;
+   double bb = s - a;
+   return DoubleDouble(s, (a - (s - bb)) + (b - bb));
+}
+
+// Same as twoSum when |a| >= |b|, with fewer operations
+inline DoubleDouble quickTwoSum(double a, double b)
+{
+   double s = a + b;
+   return DoubleDouble(s, b - (s - a));
+}
+
+// a * b exactly as a rounded product and its error, each factor split into
+// two halves of 26 bits whose products are exact
+inline DoubleDouble twoProduct(double a, double b)
+{
+   const double splitter = 134217729.0; //2^27 + 1
+   double p = a*b;
+   double t = splitter*a;
+   double aHi = t - (t - a);
+   double aLo = a - aHi;
+   t = splitter*b;
+   double bHi = t - (t - b);
+   double bLo = b - bHi;
+   return DoubleDouble(p, ((aHi*bHi - p) + aHi*bLo + aLo*bHi) + aLo*bLo);
+}
+
+inline DoubleDouble operator+(DoubleDouble x, DoubleDouble y)
+{
+   DoubleDouble s = twoSum(x.hi, y.hi);
+   DoubleDouble t = twoSum(x.lo, y.lo);
+   s.lo += t.hi;
+   s = quickTwoSum(s.hi, s.lo);
+   s.lo += t.lo;
+   return quickTwoSum(s.hi, s.lo);
+}
+
+inline DoubleDouble operator-(DoubleDouble x)
+{
+   return DoubleDouble(-x.hi, -x.lo);
+}
+
+inline DoubleDouble operator-(DoubleDouble x, DoubleDouble y)
+{
+   return x + (-y);
+}
+
+inline DoubleDouble operator*(DoubleDouble x, DoubleDouble y)
+{
+   DoubleDouble p = twoProduct(x.hi, y.hi);
+   p.lo += x.hi*y.lo + x.lo*y.hi;
+   return quickTwoSum(p.hi, p.lo);
+}
+
+// Long division: three quotient digits, each taken from the remainder left
+// by the ones before
+inline DoubleDouble operator/(DoubleDouble x, DoubleDouble y)
+{
+   double q1 = x.hi/y.hi;
+   DoubleDouble r = x - y*DoubleDouble(q1);
+   double q2 = r.hi/y.hi;
+   r = r - y*DoubleDouble(q2);
+   double q3 = r.hi/y.hi;
+   return quickTwoSum(q1, q2) + DoubleDouble(q3);
+}
+
+inline DoubleDouble& operator+=(DoubleDouble &x, DoubleDouble y)
+{
+   x = x + y;
+   return x;
+}
+
+inline double toDouble(DoubleDouble x) { return x.hi + x.lo; }
+inline double toDouble(double x) { return x; }
+inline double toDouble(float x) { return x; }
+#endif
@@ -0,0 +1,286 @@
+#include "AlgImpl.h"
+
+// Fully unrolled radix-2 FFTs for the power of two sizes up to
+// maxCodeletSize. Every butterfly index and twiddle factor is a compile
+// time constant, so a codelet is straight line code on values the
+// compiler keeps in registers, with no plan lookup, loop or bit reversal
+// at run time. The butterflies are the ones radix2Passes does, in the same
+// order of operations, so the results are the same. They run on Poly and
+// on float values, whose twiddles are the double ones rounded once more.
+
+static_assert(sizeof(Poly) == 2*sizeof(double), "codelets read Poly as interleaved doubles");
+static_assert(sizeof(ScalarComplex<float>) == 2*sizeof(float), "codelets read float values as interleaved floats");
+
+//pi in long double, the twiddles are rounded to double once from it
+constexpr long double codeletPi = 3.14159265358979323846264338327950288L;
+
+// sin(x)/x and cos(x) as nested Taylor series, for |x| <= PI/4 the terms
+// left out are below long double precision
+constexpr long double sinSeries(long double x2, int k)
+{
+   return k > 12 ? 1.0L : 1.0L - x2/((2*k)*(2*k+1))*sinSeries(x2, k+1);
+}
+
+constexpr long double cosSeries(long double x2, int k)
+{
+   return k > 12 ? 1.0L : 1.0L - x2/((2*k-1)*(2*k))*cosSeries(x2, k+1);
+}
+
+constexpr long double sinOf(long double theta)
+{
+   return theta*sinSeries(theta*theta, 1);
+}
+
+constexpr long double cosOf(long double theta)
+{
+   return cosSeries(theta*theta, 1);
+}
+
+// The angle 2*PI*k/n is 2*PI*a/d with a = 8k, d = 8n, folded into [0, PI/4]
+// by the same three steps as reduceAngle in Precision.cpp, so the twiddles
+// match the roots of the FFTPlan
+constexpr long long negatedA(long long k, long long n)
+{
+   return 2*k > n ? 8*(n-k) : 8*k;
+}
+
+constexpr bool rotates(long long k, long long n)
+{
+   return 4*negatedA(k, n) > 8*n;
+}
+
+constexpr long long rotatedA(long long k, long long n)
+{
+   return rotates(k, n) ? negatedA(k, n) - 2*n : negatedA(k, n);
+}
+
+constexpr bool swaps(long long k, long long n)
+{
+   return rotatedA(k, n) > n;
+}
+
+constexpr long double reducedTheta(long long k, long long n)
+{
+   return codeletPi*(swaps(k, n) ? 2*n - rotatedA(k, n) : rotatedA(k, n))/(4.0L*n);
+}
+
+// Real and imaginary part of the kth nth root of unity
+constexpr double codeletRootReal(long long k, long long n)
+{
+   return rotates(k, n) ? -(double)(swaps(k, n) ? cosOf(reducedTheta(k, n)) : sinOf(reducedTheta(k, n)))
+                        : (double)(swaps(k, n) ? sinOf(reducedTheta(k, n)) : cosOf(reducedTheta(k, n)));
+}
+
+constexpr double codeletRootImag(long long k, long long n)
+{
+   return (2*k > n ? -1 : 1) *
+          (double)((rotates(k, n) != swaps(k, n)) ? cosOf(reducedTheta(k, n)) : sinOf(reducedTheta(k, n)));
+}
+
+constexpr int log2Of(int n)
+{
+   return n <= 1 ? 0 : 1 + log2Of(n/2);
+}
+
+constexpr int reverseBits(int i, int bits)
+{
+   return bits == 0 ? 0 : ((i & 1) << (bits-1)) | reverseBits(i >> 1, bits-1);
+}
+
+// Which twiddle a butterfly uses: 1 and i need no multiply, the rest use
+// the complex multiply of radix2Passes. DONE ends the recursion over k.
+enum TwiddleKind { TWIDDLE_DONE, TWIDDLE_ONE, TWIDDLE_I, TWIDDLE_GENERAL };
+
+template <typename T>
+__attribute__((always_inline)) static inline void butterfly(T *re, T *im, int k, int half, T tReal, T tImag)
+{
+   T evenReal = re[k];
+   T evenImag = im[k];
+   re[k] = evenReal+tReal;
+   im[k] = evenImag+tImag;
+   re[k+half] = evenReal-tReal;
+   im[k+half] = evenImag-tImag;
+}
+
+// The butterflies of the pass combining two blocks of N/2 into one of N,
+// unrolled by recursing from K to K+1
+template <typename T, int N, int K,
+          TwiddleKind Kind = K == N/2 ? TWIDDLE_DONE : K == 0 ? TWIDDLE_ONE : 4*K == N ? TWIDDLE_I : TWIDDLE_GENERAL>
+struct CodeletButterflies;
+
+template <typename T, int N, int K>
+struct CodeletButterflies<T, N, K, TWIDDLE_DONE>
+{
+   static void apply(T*, T*) {}
+};
+
+template <typename T, int N, int K>
+struct CodeletButterflies<T, N, K, TWIDDLE_ONE>
+{
+   __attribute__((always_inline)) static void apply(T *re, T *im)
+   {
+      butterfly(re, im, K, N/2, re[K+N/2], im[K+N/2]);
+      CodeletButterflies<T, N, K+1>::apply(re, im);
+   }
+};
+
+template <typename T, int N, int K>
+struct CodeletButterflies<T, N, K, TWIDDLE_I>
+{
+   __attribute__((always_inline)) static void apply(T *re, T *im)
+   {
+      butterfly(re, im, K, N/2, (-1)*im[K+N/2], re[K+N/2]);
+      CodeletButterflies<T, N, K+1>::apply(re, im);
+   }
+};
+
+template <typename T, int N, int K>
+struct CodeletButterflies<T, N, K, TWIDDLE_GENERAL>
+{
+   __attribute__((always_inline)) static void apply(T *re, T *im)
+   {
+      constexpr T rootReal = codeletRootReal(K, N);
+      constexpr T rootImag = codeletRootImag(K, N);
+      T oddReal = re[K+N/2];
+      T oddImag = im[K+N/2];
+      T tReal = (rootReal*oddReal)+((-1)*(rootImag*oddImag));
+      T tImag = (rootReal*oddImag)+(rootImag*oddReal);
+      butterfly(re, im, K, N/2, tReal, tImag);
+      CodeletButterflies<T, N, K+1>::apply(re, im);
+   }
+};
+
+// Every pass of an N point transform of bit reversed input: both halves
+// are transformed, then combined
+template <typename T, int N>
+struct CodeletPasses
+{
+   __attribute__((always_inline)) static void run(T *re, T *im)
+   {
+      CodeletPasses<T, N/2>::run(re, im);
+      CodeletPasses<T, N/2>::run(re+N/2, im+N/2);
+      CodeletButterflies<T, N, 0>::apply(re, im);
+   }
+};
+
+template <typename T>
+struct CodeletPasses<T, 1>
+{
+   static void run(T*, T*) {}
+};
+
+// Splits interleaved input into real and imaginary arrays in bit reversed
+// order, with the permutation worked out at compile time
+template <typename T, int N, int I>
+struct CodeletLoad
+{
+   __attribute__((always_inline)) static void run(const T *data, T *re, T *im)
+   {
+      constexpr int j = reverseBits(I, log2Of(N));
+      re[j] = data[2*I];
+      im[j] = data[2*I+1];
+      CodeletLoad<T, N, I+1>::run(data, re, im);
+   }
+};
+
+template <typename T, int N>
+struct CodeletLoad<T, N, N>
+{
+   static void run(const T*, T*, T*) {}
+};
+
+// This function is the complete N point transform of polys in natural order
+template <int N, typename C>
+static void codeletTransform(C *polys)
+{
+   typedef typename ScalarOf<C>::type T;
+   T *data = reinterpret_cast<T*>(polys);
+   T re[N], im[N];
+   CodeletLoad<T, N, 0>::run(data, re, im);
+   CodeletPasses<T, N>::run(re, im);
+   for(int k=0; k<N; k++)
+   {
+      data[2*k] = re[k];
+      data[2*k+1] = im[k];
+   }
+}
+
+// This function runs the N point passes on every block of N of n values
+// that are already in bit reversed order
+template <int N, typename C>
+static void codeletPasses(C *polys, int n)
+{
+   typedef typename ScalarOf<C>::type T;
+   T *data = reinterpret_cast<T*>(polys);
+   T re[N], im[N];
+   for(int start=0; start<n; start+=N)
+   {
+      T *block = data+2*start;
+      for(int k=0; k<N; k++)
+      {
+         re[k] = block[2*k];
+         im[k] = block[2*k+1];
+      }
+      CodeletPasses<T, N>::run(re, im);
+      for(int k=0; k<N; k++)
+      {
+         block[2*k] = re[k];
+         block[2*k+1] = im[k];
+      }
+   }
+}
+
+// This function transforms a small polynomial in place with the codelet
+// for its size. It needs no FFTPlan, so millions of tiny transforms never
+// touch the plan cache.
+// Pre: polys - n coefficients, n a power of two <= maxCodeletSize
+// Post: polys[k] holds the polynomial evaluated at the kth root of unity
+template <typename C>
+void codeletFFT(C *polys, int n)
+{
+   switch(n)
+   {
+      case 2: codeletTransform<2>(polys); break;
+      case 4: codeletTransform<4>(polys); break;
+      case 8: codeletTransform<8>(polys); break;
+      case 16: codeletTransform<16>(polys); break;
+      case 32: codeletTransform<32>(polys); break;
+      case 64: codeletTransform<64>(polys); break;
+   }
+}
+
+// This function does the first butterfly passes of a larger radix-2 FFT,
+// up to blocks of len, with the codelets. These are the passes whose loops
+// are too short to run well: len 2 has one butterfly per block.
+// Pre: polys - n values in bit reversed order, n a power of two
+//      len - a power of two <= min(n, maxCodeletSize)
+// Post: Every block of len holds the transform of its values
+template <typename C>
+void codeletBlocks(C *polys, int n, int len)
+{
+   switch(len)
+   {
+      case 2: codeletPasses<2>(polys, n); break;
+      case 4: codeletPasses<4>(polys, n); break;
+      case 8: codeletPasses<8>(polys, n); break;
+      case 16: codeletPasses<16>(polys, n); break;
+      case 32: codeletPasses<32>(polys, n); break;
+      case 64: codeletPasses<64>(polys, n); break;
+   }
+}
+
+// Double-double transforms never get here, see hasCodelets
+template <>
+void codeletFFT(ScalarComplex<DoubleDouble>*, int)
+{
+}
+
+template <>
+void codeletBlocks(ScalarComplex<DoubleDouble>*, int, int)
+{
+}
+
+template void codeletFFT<Poly>(Poly*, int);
+template void codeletFFT<ScalarComplex<float> >(ScalarComplex<float>*, int);
+template void codeletBlocks<Poly>(Poly*, int, int);
+template void codeletBlocks<ScalarComplex<float> >(ScalarComplex<float>*, int, int);
@@ -0,0 +1,259 @@
+#include "AlgImpl.h"
+#include "Precision.h"
+
+// This constructor precomputes the roots of unity, also split in two small
+// tables, and picks the FFT algorithm for size n: the twiddle factors of
+// every butterfly pass for powers of two, the radices and digit reversal for
+// sizes made of 2, 3 and 5, and the chirp and convolution kernel for
+// Bluestein's algorithm otherwise. Powers of two from the four-step
+// threshold on only get the split tables, the four-step FFT needs nothing
+// else and the n roots would cost 32n bytes and n cos/sin calls.
+// Pre: n > 0
+// Post: The plan can be shared by every evaluator working on size n
+template <typename T>
+BasicFFTPlan<T>::BasicFFTPlan(int n) : n(n), rootShift(0), convSize(0)
+{
+   bool powerOfTwo = (n & (n-1)) == 0;
+   splitOnly = powerOfTwo && n >= getFourStepThreshold();
+   while((1LL << 2*rootShift) < n)
+   {
+      rootShift++;
+   }
+   fineR.resize(std::min(n, 1 << rootShift));
+   fineI.resize(fineR.size());
+   for(int r=0; r<(int)fineR.size(); r++)
+   {
+      rootOfUnity<T>(r, n, fineR[r], fineI[r]);
+   }
+   coarseR.resize(((n-1) >> rootShift) + 1);
+   coarseI.resize(((n-1) >> rootShift) + 1);
+   for(int q=0; q<(int)coarseR.size(); q++)
+   {
+      rootOfUnity<T>((long long)q << rootShift, n, coarseR[q], coarseI[q]);
+   }
+   if(!splitOnly)
+   {
+      needFullTables();
+   }
+
+   //factor n into the radices the mixed radix passes support
+   int rest = n;
+   const int smallPrimes[] = {5, 3, 2};
+   for(int i=0; i<3; i++)
+   {
+      while(rest % smallPrimes[i] == 0)
+      {
+         radices.push_back(smallPrimes[i]);
+         rest /= smallPrimes[i];
+      }
+   }
+
+   if(powerOfTwo)
+   {
+      algorithm = FFT_RADIX2;
+      radices.clear();
+   }
+   else if(rest == 1)
+   {
+      algorithm = FFT_MIXED_RADIX;
+      digitReversal.resize(n);
+      for(int i=0; i<n; i++)
+      {
+         //input i lands where its digits, read in reverse, point to
+         int pos = 0;
+         int remaining = i;
+         int subLen = n;
+         for(int f=0; f<(int)radices.size(); f++)
+         {
+            subLen /= radices[f];
+            pos += (remaining % radices[f])*subLen;
+            remaining /= radices[f];
+         }
+         digitReversal[pos] = i;
+      }
+   }
+   else
+   {
+      algorithm = FFT_BLUESTEIN;
+      radices.clear();
+      convSize = 1;
+      while(convSize < 2*n-1)
+      {
+         convSize <<= 1;
+      }
+      convPlan = getFFTPlan<T>(convSize);
+
+      chirpR.resize(n);
+      chirpI.resize(n);
+      for(int k=0; k<n; k++)
+      {
+         //k^2 mod 2n keeps the angle small so the chirp stays accurate
+         long long kSquared = ((long long)k*k) % (2LL*n);
+         rootOfUnity<T>(kSquared, 2LL*n, chirpR[k], chirpI[k]);
+      }
+
+      //kernel is the conjugate chirp wrapped around both ends of the buffer
+      typedef typename ComplexOf<T>::type Complex;
+      std::vector<Complex> kernel(convSize);
+      kernel[0] = Complex(chirpR[0], -chirpI[0]);
+      for(int k=1; k<n; k++)
+      {
+         kernel[k] = Complex(chirpR[k], -chirpI[k]);
+         kernel[convSize-k] = Complex(chirpR[k], -chirpI[k]);
+      }
+      radix2FFT(&kernel[0], convSize, *convPlan);
+      kernelR.resize(convSize);
+      kernelI.resize(convSize);
+      for(int k=0; k<convSize; k++)
+      {
+         kernelR[k] = kernel[k].getReal();
+         kernelI[k] = kernel[k].getImag();
+      }
+   }
+}
+
+// This function fills the n roots of unity and, for powers of two, the
+// twiddles of every butterfly pass. Runs once per plan, from the constructor
+// or the first time a split only plan is asked for the full tables.
+// Post: rootsR, rootsI and the twiddles are filled
+template <typename T>
+void BasicFFTPlan<T>::buildFullTables() const
+{
+   rootsR.resize(n);
+   rootsI.resize(n);
+   for(int k=0; k<n; k++)
+   {
+      rootOfUnity<T>(k, n, rootsR[k], rootsI[k]);
+   }
+   if(n > 1 && (n & (n-1)) == 0)
+   {
+      twiddlesR.resize(n-1);
+      twiddlesI.resize(n-1);
+      for(int len=2; len<=n; len <<= 1)
+      {
+         int half = len/2;
+         for(int k=0; k<half; k++)
+         {
+            twiddlesR[half-1+k] = rootsR[k*(n/len)];
+            twiddlesI[half-1+k] = rootsI[k*(n/len)];
+         }
+      }
+   }
+}
+
+//the NTT primes c*2^k + 1 and a primitive root modulo each
+static const uint64_t nttPrimes[nttPrimeCount] = {4611615649683210241ULL, 4611627194555301889ULL};
+static const uint64_t nttGenerators[nttPrimeCount] = {11, 7};
+
+// This constructor builds the Montgomery arithmetic modulo the given NTT
+// prime and the twiddles of every butterfly pass of size n from a primitive
+// nth root of unity, g^((p-1)/n) for the primitive root g
+// Pre: 0 <= prime < nttPrimeCount, n a power of two
+// Post: The plan can be shared by every transform of size n modulo the prime
+NTTPlan::NTTPlan(int prime, int n) : n(n), field(nttPrimes[prime]), twiddles(std::max(1, n-1)),
+                                     inverseTwiddles(std::max(1, n-1))
+{
+   uint64_t p = field.p;
+   uint64_t w = field.power(field.toMontgomery(nttGenerators[prime]), (p-1)/n);
+   root = field.fromMontgomery(w);
+   //w^-1 = w^(n-1)
+   uint64_t wInverse = field.power(w, n-1);
+   scale = field.power(field.toMontgomery(n), p-2);
+   for(int len=2; len<=n; len <<= 1)
+   {
+      //w_len = w^(n/len)
+      uint64_t step = field.power(w, n/len);
+      uint64_t inverseStep = field.power(wInverse, n/len);
+      uint64_t cur = field.toMontgomery(1);
+      uint64_t inverseCur = cur;
+      for(int j=0; j<len/2; j++)
+      {
+         twiddles[len/2-1+j] = field.reduce(cur);
+         inverseTwiddles[len/2-1+j] = field.reduce(inverseCur);
+         cur = field.mul(cur, step);
+         inverseCur = field.mul(inverseCur, inverseStep);
+      }
+   }
+}
+
+// This function gives the NTT prime of the given index
+uint64_t nttModulus(int prime)
+{
+   return nttPrimes[prime];
+}
+
+static std::mutex planMutex;
+static std::map<std::pair<int, int>, std::shared_ptr<const NTTPlan> > nttPlanCache;
+
+// This function holds the cached plans of scalar type T, by size
+template <typename T>
+static std::map<int, std::shared_ptr<const BasicFFTPlan<T> > >& planCache()
+{
+   static std::map<int, std::shared_ptr<const BasicFFTPlan<T> > > cache;
+   return cache;
+}
+
+// This function returns the shared plan for size n, building it the first
+// time the size is seen. Safe to call from several threads at once.
+// Pre: n > 0
+// Post: A plan for size n is returned and kept in the cache
+template <typename T>
+std::shared_ptr<const BasicFFTPlan<T> > getFFTPlan(int n)
+{
+   std::map<int, std::shared_ptr<const BasicFFTPlan<T> > > &cache = planCache<T>();
+   {
+      std::lock_guard<std::mutex> lock(planMutex);
+      typename std::map<int, std::shared_ptr<const BasicFFTPlan<T> > >::iterator it = cache.find(n);
+      if(it != cache.end())
+      {
+         return it->second;
+      }
+   }
+   //build outside the lock so other sizes are not held up by the trig calls
+   std::shared_ptr<const BasicFFTPlan<T> > plan = std::make_shared<BasicFFTPlan<T> >(n);
+   std::lock_guard<std::mutex> lock(planMutex);
+   //another thread may have built the same size in the meantime
+   return cache.insert(std::make_pair(n, plan)).first->second;
+}
+
+// This function is the same as above for the double plans
+std::shared_ptr<const FFTPlan> getFFTPlan(int n)
+{
+   return getFFTPlan<double>(n);
+}
+
+// This function is getFFTPlan for the NTT modulo one of the NTT primes
+// Pre: 0 <= prime < nttPrimeCount, n a power of two
+// Post: A plan for size n modulo the prime is returned and kept in the cache
+std::shared_ptr<const NTTPlan> getNTTPlan(int prime, int n)
+{
+   std::pair<int, int> key(prime, n);
+   {
+      std::lock_guard<std::mutex> lock(planMutex);
+      std::map<std::pair<int, int>, std::shared_ptr<const NTTPlan> >::iterator it = nttPlanCache.find(key);
+      if(it != nttPlanCache.end())
+      {
+         return it->second;
+      }
+   }
+   std::shared_ptr<const NTTPlan> plan = std::make_shared<NTTPlan>(prime, n);
+   std::lock_guard<std::mutex> lock(planMutex);
+   return nttPlanCache.insert(std::make_pair(key, plan)).first->second;
+}
+
+// This function drops every cached plan, plans still held by callers stay valid
+void clearFFTPlanCache()
+{
+   std::lock_guard<std::mutex> lock(planMutex);
+   planCache<float>().clear();
+   planCache<double>().clear();
+   planCache<DoubleDouble>().clear();
+   nttPlanCache.clear();
+}
+
+template class BasicFFTPlan<float>;
+template class BasicFFTPlan<double>;
+template class BasicFFTPlan<DoubleDouble>;
+template std::shared_ptr<const BasicFFTPlan<float> > getFFTPlan<float>(int);
+template std::shared_ptr<const BasicFFTPlan<double> > getFFTPlan<double>(int);
+template std::shared_ptr<const BasicFFTPlan<DoubleDouble> > getFFTPlan<DoubleDouble>(int);
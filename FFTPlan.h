@@ -0,0 +1,181 @@
+#ifndef FFTPLAN_H
+#define FFTPLAN_H
+#include <math.h>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "Montgomery.h"
+#include "Poly.h"
+#include "DoubleDouble.h"
+
+#define PI 3.14159265358979323846
+
+// Algorithm the FFT uses for a given size, picked when the plan is built
+enum FFTAlgorithm
+{
+   FFT_RADIX2,      // n is a power of two
+   FFT_MIXED_RADIX, // n only has prime factors 2, 3 and 5
+   FFT_BLUESTEIN    // any other n, done as a power of two convolution
+};
+
+// The complex value the FFT in scalar type T transforms in place: Poly for
+// double and this pair, with the same accessors, for float and double-double
+template <typename T>
+class ScalarComplex
+{
+   private:
+      T real;
+      T imag;
+
+   public:
+      typedef T Scalar;
+      ScalarComplex() : real(0), imag(0) {}
+      ScalarComplex(T real, T imag) : real(real), imag(imag) {}
+      T getReal() const { return real; }
+      T getImag() const { return imag; }
+};
+
+// The complex type of a scalar type and the scalar type of a complex one
+template <typename T> struct ComplexOf { typedef ScalarComplex<T> type; };
+template <> struct ComplexOf<double> { typedef Poly type; };
+template <typename C> struct ScalarOf { typedef typename C::Scalar type; };
+template <> struct ScalarOf<Poly> { typedef double type; };
+
+// An FFTPlan holds everything about a polynomial size n that does not depend
+// on the coefficients: the n roots of unity the evaluators work at and the
+// twiddle factors used by the butterfly passes of the FFT. Plans are built
+// once per size and shared through getFFTPlan, so repeated evaluations of the
+// same degree never call cos/sin again. Powers of two the four-step FFT
+// handles only build the two split root tables up front; the n roots and the
+// twiddles are built the first time something asks for them. The tables are
+// in the scalar type T the transform runs in, FFTPlan is the double plan.
+template <typename T>
+class BasicFFTPlan
+{
+   private:
+      int n;
+      bool splitOnly;
+      mutable std::once_flag fullTablesBuilt;
+      mutable std::vector<T> rootsR;
+      mutable std::vector<T> rootsI;
+      int rootShift;
+      std::vector<T> fineR;
+      std::vector<T> fineI;
+      std::vector<T> coarseR;
+      std::vector<T> coarseI;
+      mutable std::vector<T> twiddlesR;
+      mutable std::vector<T> twiddlesI;
+      FFTAlgorithm algorithm;
+      std::vector<int> radices;
+      std::vector<int> digitReversal;
+      int convSize;
+      std::shared_ptr<const BasicFFTPlan<T> > convPlan;
+      std::vector<T> chirpR;
+      std::vector<T> chirpI;
+      std::vector<T> kernelR;
+      std::vector<T> kernelI;
+
+      void buildFullTables() const;
+      void needFullTables() const { std::call_once(fullTablesBuilt, &BasicFFTPlan::buildFullTables, this); }
+
+   public:
+      BasicFFTPlan(int n);
+      int size() const { return n; }
+      // kth root of unity, cos(2*PI*k/n) + i*sin(2*PI*k/n), put together from
+      // the split tables when the plan has no full table
+      T rootReal(int k) const
+      {
+         if(!splitOnly)
+         {
+            return rootsR[k];
+         }
+         int low = k & ((1 << rootShift) - 1), high = k >> rootShift;
+         return (fineR[low]*coarseR[high])+((-1)*(fineI[low]*coarseI[high]));
+      }
+      T rootImag(int k) const
+      {
+         if(!splitOnly)
+         {
+            return rootsI[k];
+         }
+         int low = k & ((1 << rootShift) - 1), high = k >> rootShift;
+         return (fineR[low]*coarseI[high])+(fineI[low]*coarseR[high]);
+      }
+      const T* rootsReal() const { needFullTables(); return &rootsR[0]; }
+      const T* rootsImag() const { needFullTables(); return &rootsI[0]; }
+      // The same roots split in two tables of about sqrt(n) entries that stay
+      // in the cache: with s = getRootShift(), w^e = fineRoot(e mod 2^s) *
+      // coarseRoot(e >> s), where fineRoot(r) = w^r and coarseRoot(q) = w^(q*2^s)
+      int getRootShift() const { return rootShift; }
+      const T* fineRootsReal() const { return &fineR[0]; }
+      const T* fineRootsImag() const { return &fineI[0]; }
+      const T* coarseRootsReal() const { return &coarseR[0]; }
+      const T* coarseRootsImag() const { return &coarseI[0]; }
+      // Twiddles of the butterfly pass combining blocks of length len are
+      // stored contiguously starting at len/2-1, so a pass reads them in order.
+      // Only present when n is a power of two.
+      const T* twiddleReal(int len) const { needFullTables(); return &twiddlesR[len/2-1]; }
+      const T* twiddleImag(int len) const { needFullTables(); return &twiddlesI[len/2-1]; }
+      FFTAlgorithm getAlgorithm() const { return algorithm; }
+
+      // Mixed radix: factors of n in the order the recursion splits on them
+      // and the digit reversal permutation, position i reads input digitReversal[i]
+      const std::vector<int>& getRadices() const { return radices; }
+      const int* getDigitReversal() const { return &digitReversal[0]; }
+
+      // Bluestein: power of two convolution length and its plan, the chirp
+      // e^(i*PI*k^2/n) for k < n and the transformed conjugate chirp kernel
+      int getConvSize() const { return convSize; }
+      const BasicFFTPlan<T>& getConvPlan() const { return *convPlan; }
+      T chirpReal(int k) const { return chirpR[k]; }
+      T chirpImag(int k) const { return chirpI[k]; }
+      T kernelReal(int k) const { return kernelR[k]; }
+      T kernelImag(int k) const { return kernelI[k]; }
+};
+
+typedef BasicFFTPlan<double> FFTPlan;
+
+// The plan type of the transforms of complex type C
+template <typename C> using PlanOf = BasicFFTPlan<typename ScalarOf<C>::type>;
+
+// Primes of the form c*2^k + 1 below 2^62 the NTT works modulo, every one
+// has roots of unity of all power of two orders up to 2^39
+const int nttPrimeCount = 2;
+
+// An NTTPlan is the FFTPlan of the number theoretic transform: for a power
+// of two n and one of the NTT primes p it holds the Montgomery arithmetic
+// modulo p, a primitive nth root of unity w mod p and the twiddles of every
+// butterfly pass, forward and inverse, in Montgomery form. Plans are cached
+// and shared through getNTTPlan along with the FFT plans.
+class NTTPlan
+{
+   private:
+      int n;
+      Montgomery field;
+      uint64_t root;
+      uint64_t scale;
+      std::vector<uint64_t> twiddles;
+      std::vector<uint64_t> inverseTwiddles;
+
+   public:
+      NTTPlan(int prime, int n);
+      int size() const { return n; }
+      uint64_t modulus() const { return field.p; }
+      const Montgomery& arithmetic() const { return field; }
+      // w, with w^n = 1 mod p and no smaller power 1, not in Montgomery form
+      uint64_t getRoot() const { return root; }
+      // n^-1 mod p in Montgomery form, undoes the n of a forward and inverse pair
+      uint64_t getScale() const { return scale; }
+      // Twiddles w_len^j for j < len/2 of the pass over blocks of length len,
+      // stored contiguously starting at len/2-1 as in FFTPlan
+      const uint64_t* twiddle(int len) const { return &twiddles[len/2-1]; }
+      const uint64_t* inverseTwiddle(int len) const { return &inverseTwiddles[len/2-1]; }
+};
+
+std::shared_ptr<const FFTPlan> getFFTPlan(int n);
+template <typename T> std::shared_ptr<const BasicFFTPlan<T> > getFFTPlan(int n);
+std::shared_ptr<const NTTPlan> getNTTPlan(int prime, int n);
+uint64_t nttModulus(int prime);
+void clearFFTPlanCache();
+#endif
@@ -0,0 +1,199 @@
+#include "AlgImpl.h"
+
+//power of two transforms of at least this many points use the four-step FFT
+static std::atomic<int> fourStepThreshold(1 << 18);
+//columns gathered and transformed together, a multiple of the 4 Polys in a
+//cache line so the gather reads whole lines
+static const int columnBlock = 8;
+//padding between the gathered columns, a power of two stride would map
+//every column's same element to the same cache set
+static const int columnPadding = 4;
+//side of the square tiles the transpose swaps
+static const int tileSize = 32;
+
+// This function sets the size from which power of two transforms are done
+// with the four-step FFT instead of the radix-2 passes over the whole buffer.
+// Around the last level cache size the radix-2 passes start missing the
+// cache on every level, the four-step FFT keeps each small transform in it.
+// Pre: threshold >= 4
+void setFourStepThreshold(int threshold)
+{
+   fourStepThreshold = std::max(4, threshold);
+}
+
+int getFourStepThreshold()
+{
+   return fourStepThreshold;
+}
+
+// This function transforms one row or column of the four-step FFT serially,
+// they are the units the threads split the work into
+// Pre: polys - len values, len a power of two
+//      plan  - the plan for any power of two size >= len
+template <typename C>
+static void leafFFT(C *polys, int len, const PlanOf<C> &plan)
+{
+   if(len <= maxCodeletSize && hasCodelets<C>())
+   {
+      codeletFFT(polys, len);
+      return;
+   }
+   bitReverse(polys, len);
+   radix2Passes(polys, len, plan);
+}
+
+// This function transposes the square side x side matrix at polys in place,
+// swapping tiles that fit in the L1 cache together, every thread takes a
+// range of tile rows and the tiles right of the diagonal in them
+template <typename C>
+static void transposeSquare(C *polys, int side)
+{
+   int tile = std::min(side, tileSize);
+   parallelFor(0, side/tile, [&](int rowBegin, int rowEnd)
+   {
+      for(int bi=rowBegin; bi<rowEnd; bi++)
+      {
+         for(int bj=bi; bj<side/tile; bj++)
+         {
+            for(int i=bi*tile; i<(bi+1)*tile; i++)
+            {
+               //on the diagonal tile only the part right of the diagonal
+               int jBegin = bi == bj ? i+1 : bj*tile;
+               for(int j=jBegin; j<(bj+1)*tile; j++)
+               {
+                  std::swap(polys[i*side+j], polys[j*side+i]);
+               }
+            }
+         }
+      }
+   });
+}
+
+// This function transposes the rows x 2*rows matrix at polys in place. Its
+// left and right halves are each square, so the rows' halves are first
+// sorted into all left halves followed by all right halves, following the
+// cycles of that permutation with one row half of scratch, and then both
+// squares are transposed on their own.
+template <typename C>
+static void transposeWide(C *polys, int rows)
+{
+   WorkspaceFrame frame;
+   C *temp = frame.allocate<C>(rows);
+   char *moved = frame.allocate<char>(2*rows);
+   std::fill(moved, moved+2*rows, 0);
+   for(int start=0; start<2*rows; start++)
+   {
+      if(moved[start])
+      {
+         continue;
+      }
+      //half h of row r moves to block h*rows + r
+      std::copy(polys+(size_t)start*rows, polys+(size_t)(start+1)*rows, temp);
+      int cur = start;
+      do
+      {
+         int next = (cur%2)*rows + cur/2;
+         std::swap_ranges(temp, temp+rows, polys+(size_t)next*rows);
+         moved[next] = 1;
+         cur = next;
+      } while(cur != start);
+   }
+   transposeSquare(polys, rows);
+   transposeSquare(polys+(size_t)rows*rows, rows);
+}
+
+// This function implements the four-step FFT of Bailey. With n = n1*n2 the
+// input is an n1 x n2 matrix, x[j1*n2 + j2], and with k = k1 + n1*k2
+//    X_k = sum over j2 of w^(j2*k1) * w_n2^(j2*k2) * (sum over j1 of x * w_n1^(j1*k1))
+// which is n2 column transforms of size n1, a twiddle multiply, n1 row
+// transforms of size n2 and a transpose. Columns are gathered a few at a
+// time into a contiguous buffer, transformed, and scattered back with the
+// twiddle applied, so every transform works within the cache and the main
+// buffer is streamed through a small number of times. The twiddles come
+// from the plan's split root tables, which stay in the cache where the n
+// roots would not, and are the only tables a plan this size builds.
+// Pre: polys - n coefficients, n >= 4 a power of two
+//      plan  - the plan for size n
+// Post: polys[k] holds the polynomial evaluated at the kth root of unity
+template <typename C>
+void fourStepFFT(C *polys, int n, const PlanOf<C> &plan)
+{
+   typedef typename ScalarOf<C>::type T;
+   int log1 = 0;
+   while((2 << 2*log1) < n)
+   {
+      log1++;
+   }
+   int n1 = 1 << log1;
+   int n2 = n/n1;
+   std::shared_ptr<const PlanOf<C> > leafPlan = getFFTPlan<T>(n2);
+
+   //twiddles come from the plan's split root tables
+   int shift = plan.getRootShift();
+   int lowMask = (1 << shift) - 1;
+   const T *fineReal = plan.fineRootsReal();
+   const T *fineImag = plan.fineRootsImag();
+   const T *coarseReal = plan.coarseRootsReal();
+   const T *coarseImag = plan.coarseRootsImag();
+
+   //column transforms, twiddled on the way back
+   int width = std::min(n2, columnBlock);
+   int stride = n1 + columnPadding;
+   parallelFor(0, n2/width, [&](int blockBegin, int blockEnd)
+   {
+      WorkspaceFrame blockFrame;
+      C *columns = blockFrame.allocate<C>((size_t)width*stride);
+      for(int block=blockBegin; block<blockEnd; block++)
+      {
+         int c0 = block*width;
+         for(int j1=0; j1<n1; j1++)
+         {
+            for(int c=0; c<width; c++)
+            {
+               columns[c*stride+j1] = polys[(size_t)j1*n2+c0+c];
+            }
+         }
+         for(int c=0; c<width; c++)
+         {
+            leafFFT(columns+c*stride, n1, *leafPlan);
+         }
+         for(int k1=0; k1<n1; k1++)
+         {
+            for(int c=0; c<width; c++)
+            {
+               int e = (c0+c)*k1;
+               T fReal = fineReal[e & lowMask], fImag = fineImag[e & lowMask];
+               T gReal = coarseReal[e >> shift], gImag = coarseImag[e >> shift];
+               T wReal = (fReal*gReal)+((-1)*(fImag*gImag));
+               T wImag = (fReal*gImag)+(fImag*gReal);
+               T vReal = columns[c*stride+k1].getReal();
+               T vImag = columns[c*stride+k1].getImag();
+               polys[(size_t)k1*n2+c0+c] = C((wReal*vReal)+((-1)*(wImag*vImag)), (wReal*vImag)+(wImag*vReal));
+            }
+         }
+      }
+   });
+
+   //row transforms, each row is contiguous
+   parallelFor(0, n1, [&](int rowBegin, int rowEnd)
+   {
+      for(int k1=rowBegin; k1<rowEnd; k1++)
+      {
+         leafFFT(polys+(size_t)k1*n2, n2, *leafPlan);
+      }
+   });
+
+   //X_(k1 + n1*k2) sits at row k1, column k2
+   if(n1 == n2)
+   {
+      transposeSquare(polys, n1);
+   }
+   else
+   {
+      transposeWide(polys, n1);
+   }
+}
+
+template void fourStepFFT<Poly>(Poly*, int, const FFTPlan&);
+template void fourStepFFT<ScalarComplex<float> >(ScalarComplex<float>*, int, const BasicFFTPlan<float>&);
+template void fourStepFFT<ScalarComplex<DoubleDouble> >(ScalarComplex<DoubleDouble>*, int, const BasicFFTPlan<DoubleDouble>&);
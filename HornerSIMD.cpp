@@ -0,0 +1,225 @@
+#include "AlgImpl.h"
+//the vector kernels are x86 only. They are compiled with target attributes,
+//so the build needs no -mavx2 and __AVX2__ is not defined, and the CPU is
+//checked at run time. Other targets get the scalar recurrence.
+#if defined(__x86_64__) || defined(__i386__)
+#define HORNER_SIMD_KERNELS
+#include <immintrin.h>
+#endif
+
+// Vectorized Horner evaluation. Each vector lane follows one root of unity
+// through the whole coefficient chain, so 4 (AVX2) or 8 (AVX-512) points are
+// evaluated per instruction, and four independent vectors are kept in flight
+// to hide the latency of the serially dependent complex multiply-adds.
+//
+// The kernels use fused multiply-adds, which round once where hornerEval
+// rounds twice, so the results are not bit-identical to hornerEval. Both
+// follow the same Horner recurrence, and for every point k they agree to
+//    |simd[k] - horner[k]| <= 4 * n * ulp(sum |a_i|)
+// (real and imaginary part separately), the usual Horner error bound at
+// |w| = 1 for both of them combined.
+
+// This function runs the scalar Horner recurrence for roots kStart..kEnd-1,
+// it handles the points left over after the vector groups
+static void hornerScalarRange(const double *coeffReal, const double *coeffImag, int n,
+                              const double *rootReal, const double *rootImag,
+                              double *outReal, double *outImag, int kStart, int kEnd)
+{
+   for(int k=kStart; k<kEnd; k++)
+   {
+      double bReal = coeffReal[n-1];
+      double bImag = coeffImag[n-1];
+      for(int i=n-2; i>-1; i--)
+      {
+         double bRealTemp = bReal;
+         bReal = ((bReal*rootReal[k]) + ((-1)*bImag*rootImag[k])) + coeffReal[i];
+         bImag = ((bRealTemp*rootImag[k])+(bImag*rootReal[k])) + coeffImag[i];
+      }
+      outReal[k] = bReal;
+      outImag[k] = bImag;
+   }
+}
+
+#ifdef HORNER_SIMD_KERNELS
+// This function evaluates roots kStart..kEnd-1 in groups of 16 with AVX2,
+// 4 vectors of 4 lanes
+// Post: Returns the first root that was not evaluated
+__attribute__((target("avx2,fma")))
+static int hornerAVX2(const double *coeffReal, const double *coeffImag, int n,
+                      const double *rootReal, const double *rootImag,
+                      double *outReal, double *outImag, int kStart, int kEnd)
+{
+   const int lanes = 4;
+   const int group = 4*lanes;
+   int k = kStart;
+   for(; k+group <= kEnd; k += group)
+   {
+      __m256d wR[4], wI[4], bR[4], bI[4];
+      for(int u=0; u<4; u++)
+      {
+         wR[u] = _mm256_loadu_pd(rootReal+k+u*lanes);
+         wI[u] = _mm256_loadu_pd(rootImag+k+u*lanes);
+         bR[u] = _mm256_set1_pd(coeffReal[n-1]);
+         bI[u] = _mm256_set1_pd(coeffImag[n-1]);
+      }
+      for(int i=n-2; i>-1; i--)
+      {
+         __m256d aR = _mm256_set1_pd(coeffReal[i]);
+         __m256d aI = _mm256_set1_pd(coeffImag[i]);
+         for(int u=0; u<4; u++)
+         {
+            __m256d bRTemp = bR[u];
+            bR[u] = _mm256_fmadd_pd(bRTemp, wR[u], _mm256_fnmadd_pd(bI[u], wI[u], aR));
+            bI[u] = _mm256_fmadd_pd(bRTemp, wI[u], _mm256_fmadd_pd(bI[u], wR[u], aI));
+         }
+      }
+      for(int u=0; u<4; u++)
+      {
+         _mm256_storeu_pd(outReal+k+u*lanes, bR[u]);
+         _mm256_storeu_pd(outImag+k+u*lanes, bI[u]);
+      }
+   }
+   return k;
+}
+
+// This function evaluates roots kStart..kEnd-1 in groups of 32 with AVX-512,
+// 4 vectors of 8 lanes
+// Post: Returns the first root that was not evaluated
+__attribute__((target("avx512f")))
+static int hornerAVX512(const double *coeffReal, const double *coeffImag, int n,
+                        const double *rootReal, const double *rootImag,
+                        double *outReal, double *outImag, int kStart, int kEnd)
+{
+   const int lanes = 8;
+   const int group = 4*lanes;
+   int k = kStart;
+   for(; k+group <= kEnd; k += group)
+   {
+      __m512d wR[4], wI[4], bR[4], bI[4];
+      for(int u=0; u<4; u++)
+      {
+         wR[u] = _mm512_loadu_pd(rootReal+k+u*lanes);
+         wI[u] = _mm512_loadu_pd(rootImag+k+u*lanes);
+         bR[u] = _mm512_set1_pd(coeffReal[n-1]);
+         bI[u] = _mm512_set1_pd(coeffImag[n-1]);
+      }
+      for(int i=n-2; i>-1; i--)
+      {
+         __m512d aR = _mm512_set1_pd(coeffReal[i]);
+         __m512d aI = _mm512_set1_pd(coeffImag[i]);
+         for(int u=0; u<4; u++)
+         {
+            __m512d bRTemp = bR[u];
+            bR[u] = _mm512_fmadd_pd(bRTemp, wR[u], _mm512_fnmadd_pd(bI[u], wI[u], aR));
+            bI[u] = _mm512_fmadd_pd(bRTemp, wI[u], _mm512_fmadd_pd(bI[u], wR[u], aI));
+         }
+      }
+      for(int u=0; u<4; u++)
+      {
+         _mm512_storeu_pd(outReal+k+u*lanes, bR[u]);
+         _mm512_storeu_pd(outImag+k+u*lanes, bI[u]);
+      }
+   }
+   return k;
+}
+
+#endif
+
+// This function reports the widest instruction set the Horner kernel can use
+// on this CPU, checked once
+SimdLevel detectSimdLevel()
+{
+#ifdef HORNER_SIMD_KERNELS
+   static const SimdLevel level =
+      __builtin_cpu_supports("avx512f") ? SIMD_AVX512 :
+      (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) ? SIMD_AVX2 :
+      SIMD_SCALAR;
+   return level;
+#else
+   return SIMD_SCALAR;
+#endif
+}
+
+// This function is the same as below for a PolySoA
+int hornerEvalSIMD(const PolySoA &polys, PolySoA &result, SimdLevel level)
+{
+   return hornerEvalSIMD(polys.realData(), polys.imagData(), polys.size(), result, level);
+}
+
+// This function implements horners algorithm with the vector kernels above
+// Pre: coeffReal, coeffImag - the n coefficients of a polynomial to evaluate
+//      at each of the roots of unity, in any storage (e.g. a mapped file)
+//      result - resized to hold the results of horners algorithm
+//      level  - instruction set to use, lowered to what the CPU supports
+// Post: All nth roots of unity have been computed using horners algorithm,
+//       within the tolerance above of hornerEval
+// Throws: -1 if no polynomial exists yet
+int hornerEvalSIMD(const double *coeffReal, const double *coeffImag, int n, PolySoA &result, SimdLevel level)
+{
+   if (n==0) //Check to see if we have a polynomial
+   {
+      return -1;
+   }
+   if(level > detectSimdLevel())
+   {
+      level = detectSimdLevel();
+   }
+   result.resize(n);
+   std::shared_ptr<const FFTPlan> plan = getFFTPlan(n);
+   InstrumentPhase phase("evaluate");
+   if(phase.active())
+   {
+      //8 flops per point and step like hornerEval, but the vector kernels keep
+      //a group's values in registers: a group reads every coefficient once and
+      //its roots, and stores its values, points left over run the scalar loop
+      int64_t lanes = level == SIMD_AVX512 ? 32 : level == SIMD_AVX2 ? 16 : 0;
+      int64_t grouped = lanes == 0 ? 0 : n/lanes;
+      int64_t rest = n - grouped*lanes;
+      phase.count(8*(int64_t)n*(n-1), grouped*(16*(int64_t)n + 32*lanes) + rest*(16*(int64_t)n + 32));
+   }
+   double *outReal = result.realData();
+   double *outImag = result.imagData();
+   const double *rootReal = plan->rootsReal();
+   const double *rootImag = plan->rootsImag();
+   //threads get whole groups of 32 roots so only the last range has a tail
+   const int group = 32;
+   int groups = (n+group-1)/group;
+   parallelFor(0, groups, [&](int groupBegin, int groupEnd)
+   {
+      int kStart = groupBegin*group;
+      int kEnd = std::min(n, groupEnd*group);
+      int done = kStart;
+#ifdef HORNER_SIMD_KERNELS
+      if(level == SIMD_AVX512)
+      {
+         done = hornerAVX512(coeffReal, coeffImag, n, rootReal, rootImag, outReal, outImag, kStart, kEnd);
+      }
+      else if(level == SIMD_AVX2)
+      {
+         done = hornerAVX2(coeffReal, coeffImag, n, rootReal, rootImag, outReal, outImag, kStart, kEnd);
+      }
+#endif
+      hornerScalarRange(coeffReal, coeffImag, n, rootReal, rootImag, outReal, outImag, done, kEnd);
+   });
+   return 0;
+}
+
+// This function is the same as above using the best instruction set available
+int hornerEvalSIMD(const PolySoA &polys, PolySoA &result)
+{
+   return hornerEvalSIMD(polys, result, detectSimdLevel());
+}
+
+// This function is the std::vector<Poly> version of the one above
+int hornerEvalSIMD(std::vector<Poly> &polys, std::vector<Poly> &result)
+{
+   static thread_local PolySoA coeffs, values;
+   if(polys.size()==0) //Check to see if we have a polynomial
+   {
+      return -1;
+   }
+   coeffs.fromPolys(polys);
+   hornerEvalSIMD(coeffs, values);
+   values.toPolys(result);
+   return 0;
+}
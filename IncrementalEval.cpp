@@ -0,0 +1,132 @@
+#include "IncrementalEval.h"
+
+IncrementalEvaluator::IncrementalEvaluator() : fullThreshold(0), updatesSinceFull(0)
+{
+}
+
+// This function gives the largest batch applied incrementally
+int IncrementalEvaluator::getFullThreshold() const
+{
+   if(fullThreshold > 0)
+   {
+      return fullThreshold;
+   }
+   int log2n = 0;
+   while((1 << log2n) < size())
+   {
+      log2n++;
+   }
+   return std::max(1, log2n);
+}
+
+// This function evaluates the polynomial from scratch and keeps it
+// Pre: polys - the coefficients
+// Post: getValues holds the polynomial evaluated at all n roots of unity
+// Throws: -1 if no polynomial exists yet
+int IncrementalEvaluator::evaluate(const std::vector<Poly> &polys)
+{
+   if(polys.size() == 0)
+   {
+      return -1;
+   }
+   coeffs = polys;
+   int n = coeffs.size();
+   plan = getFFTPlan(n);
+   evaluateAll();
+   return 0;
+}
+
+void IncrementalEvaluator::evaluateAll()
+{
+   std::vector<Poly> result;
+   callFFT(&coeffs[0], coeffs.size(), result);
+   values.fromPolys(result);
+   updatesSinceFull = 0;
+}
+
+// This function evaluates the kept coefficients from scratch, which also
+// drops the rounding errors the incremental changes have added up
+// Throws: -1 if nothing has been evaluated yet
+int IncrementalEvaluator::refresh()
+{
+   if(coeffs.size() == 0)
+   {
+      return -1;
+   }
+   evaluateAll();
+   return 0;
+}
+
+// This function changes coefficient j and updates every value with it,
+// O(n)
+// Pre: j - index of the coefficient, value - its new value
+// Post: getValues holds the changed polynomial evaluated at the roots
+// Throws: -1 if nothing has been evaluated yet or j is out of range
+int IncrementalEvaluator::update(int j, Poly value)
+{
+   return update(&j, &value, 1);
+}
+
+// This function changes a batch of coefficients, indices may repeat and
+// later changes win. Batches of k up to getFullThreshold changes, log2(n)
+// by default, are added to the values in one pass that costs O(k*n).
+// Larger ones are evaluated from scratch in O(n log n).
+// Pre: indices - the coefficients to change, newValues - their new values
+// Post: getValues holds the changed polynomial evaluated at the roots
+// Throws: -1 if nothing has been evaluated yet, the vectors differ in
+//         size or an index is out of range
+int IncrementalEvaluator::update(const std::vector<int> &indices, const std::vector<Poly> &newValues)
+{
+   if(indices.size() != newValues.size())
+   {
+      return -1;
+   }
+   return update(indices.data(), newValues.data(), indices.size());
+}
+
+// This function is the same as above for count changes in any arrays
+int IncrementalEvaluator::update(const int *indices, const Poly *newValues, int count)
+{
+   int n = coeffs.size();
+   if(n == 0)
+   {
+      return -1;
+   }
+   for(int c=0; c<count; c++)
+   {
+      if(indices[c] < 0 || indices[c] >= n)
+      {
+         return -1;
+      }
+   }
+
+   WorkspaceFrame frame;
+   double *deltaReal = frame.allocate<double>(count);
+   double *deltaImag = frame.allocate<double>(count);
+   for(int c=0; c<count; c++)
+   {
+      Poly cur = coeffs[indices[c]];
+      Poly next = newValues[c];
+      deltaReal[c] = next.getReal() - cur.getReal();
+      deltaImag[c] = next.getImag() - cur.getImag();
+      coeffs[indices[c]] = next;
+   }
+   if(count > getFullThreshold())
+   {
+      evaluateAll();
+   }
+   else
+   {
+      applyChanges(indices, deltaReal, deltaImag, count);
+      updatesSinceFull += count;
+   }
+   return 0;
+}
+
+// This function adds delta_c * w^(j_c*k) to every value k for each change
+// c, the sparse transform of the changes
+void IncrementalEvaluator::applyChanges(const int *indices, const double *deltaReal, const double *deltaImag,
+                                        int count)
+{
+   sparseDFT(indices, deltaReal, deltaImag, count, *plan, values.realData(), values.imagData());
+}
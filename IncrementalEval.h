@@ -0,0 +1,44 @@
+#ifndef INCREMENTALEVAL_H
+#define INCREMENTALEVAL_H
+#include "AlgImpl.h"
+
+// Keeps a polynomial and its values at the n roots of unity, so changing a
+// few coefficients does not need a new evaluation. Changing coefficient j by
+// delta moves every value by delta * w^(jk), O(n) for one change. A batch of
+// k changes is applied in one blocked pass over the values, but every value
+// still gets every change added, so it costs O(k*n), not O(k log n). Once k
+// is above log2(n) that is more than the O(n log n) FFT, and the values are
+// simply evaluated again.
+class IncrementalEvaluator
+{
+   private:
+      std::vector<Poly> coeffs;
+      PolySoA values;
+      std::shared_ptr<const FFTPlan> plan;
+      int fullThreshold;
+      int updatesSinceFull;
+
+      void evaluateAll();
+      void applyChanges(const int *indices, const double *deltaReal, const double *deltaImag, int count);
+
+   public:
+      IncrementalEvaluator();
+      int evaluate(const std::vector<Poly> &polys);
+      int update(int j, Poly value);
+      int update(const std::vector<int> &indices, const std::vector<Poly> &newValues);
+      int update(const int *indices, const Poly *newValues, int count);
+      int refresh();
+
+      int size() const { return coeffs.size(); }
+      const std::vector<Poly>& coefficients() const { return coeffs; }
+      const PolySoA& getValues() const { return values; }
+      void getValues(std::vector<Poly> &result) const { values.toPolys(result); }
+      int changesSinceFullEvaluation() const { return updatesSinceFull; }
+
+      // Batches of more than this many changes are evaluated from scratch,
+      // 0 (the default) picks log2(n), where the O(k*n) update costs about
+      // an FFT
+      void setFullThreshold(int changes) { fullThreshold = changes; }
+      int getFullThreshold() const;
+};
+#endif
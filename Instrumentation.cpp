@@ -0,0 +1,339 @@
+#include "AlgImpl.h"
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> instrumentationOn(false);
+//allocations counted while instrumenting, from every thread
+static std::atomic<int64_t> allocationCount(0);
+static std::atomic<int64_t> allocationBytes(0);
+
+//report being collected, and where the whole evaluation started
+static std::mutex reportMutex;
+static InstrumentReport collecting;
+static PhaseCounters totalStart;
+static std::thread::id instrumentedThread;
+
+//perf_event group of the instrumented thread: cycles, instructions, cache misses
+static int perfFds[3] = {-1, -1, -1};
+
+#ifdef COUNT_ALL_ALLOCATIONS
+// Built with -DCOUNT_ALL_ALLOCATIONS every allocation of the program goes
+// through this replacement of the global operator new, so the containers
+// of the standard library are counted along with the aligned buffers.
+// Off by default, it puts a check in front of every allocation the program
+// makes, instrumented or not.
+void* operator new(size_t bytes)
+{
+   countAllocation(bytes);
+   void *block = malloc(bytes == 0 ? 1 : bytes);
+   if(block == 0)
+   {
+      throw std::bad_alloc();
+   }
+   return block;
+}
+
+void operator delete(void *block) noexcept
+{
+   free(block);
+}
+
+void operator delete(void *block, size_t) noexcept
+{
+   free(block);
+}
+#endif
+
+// This function records one allocation of bytes if instrumentation is on
+void countAllocation(size_t bytes)
+{
+   if(instrumenting())
+   {
+      allocationCount.fetch_add(1, std::memory_order_relaxed);
+      allocationBytes.fetch_add(bytes, std::memory_order_relaxed);
+   }
+}
+
+PhaseCounters::PhaseCounters() : calls(0), flops(0), bytesMoved(0), allocations(0), bytesAllocated(0),
+                                 seconds(0), hardware(false), cycles(0), instructions(0), cacheMisses(0)
+{
+}
+
+// This function gives the instructions retired per cycle
+double PhaseCounters::ipc() const
+{
+   return cycles > 0 ? (double)instructions/cycles : 0;
+}
+
+static void closeCounters()
+{
+#ifdef __linux__
+   for(int i=2; i>=0; i--)
+   {
+      if(perfFds[i] >= 0)
+      {
+         close(perfFds[i]);
+         perfFds[i] = -1;
+      }
+   }
+#endif
+}
+
+// This function opens the hardware counters of the calling thread as one
+// perf_event group, so the three are always read over the same interval
+// Post: Returns false, with nothing left open, where perf_event is missing
+//       or not permitted
+static bool openCounters()
+{
+#ifdef __linux__
+   const uint64_t configs[3] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES};
+   for(int i=0; i<3; i++)
+   {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = configs[i];
+      attr.disabled = i == 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      perfFds[i] = syscall(__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : perfFds[0], 0);
+      if(perfFds[i] < 0)
+      {
+         closeCounters();
+         return false;
+      }
+   }
+   ioctl(perfFds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+   ioctl(perfFds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+   return true;
+#else
+   return false;
+#endif
+}
+
+// This function takes the current value of every counter. Hardware counters
+// are only read on the instrumented thread, the one they count.
+static void snapshot(PhaseCounters &counters)
+{
+   counters.allocations = allocationCount.load();
+   counters.bytesAllocated = allocationBytes.load();
+   counters.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+   counters.hardware = false;
+#ifdef __linux__
+   if(perfFds[0] >= 0 && std::this_thread::get_id() == instrumentedThread)
+   {
+      uint64_t values[4];
+      if(read(perfFds[0], values, sizeof(values)) == (ssize_t)sizeof(values) && values[0] == 3)
+      {
+         counters.hardware = true;
+         counters.cycles = values[1];
+         counters.instructions = values[2];
+         counters.cacheMisses = values[3];
+      }
+   }
+#endif
+}
+
+// This function adds what changed between two snapshots to sum
+static void accumulate(const PhaseCounters &start, const PhaseCounters &end, PhaseCounters &sum)
+{
+   sum.calls++;
+   sum.allocations += end.allocations-start.allocations;
+   sum.bytesAllocated += end.bytesAllocated-start.bytesAllocated;
+   sum.seconds += end.seconds-start.seconds;
+   if(start.hardware && end.hardware)
+   {
+      sum.hardware = true;
+      sum.cycles += end.cycles-start.cycles;
+      sum.instructions += end.instructions-start.instructions;
+      sum.cacheMisses += end.cacheMisses-start.cacheMisses;
+   }
+}
+
+InstrumentPhase::InstrumentPhase(const char *name) : name(name), on(instrumenting()), flops(0), bytesMoved(0)
+{
+   if(on)
+   {
+      snapshot(start);
+   }
+}
+
+// This destructor adds the phase to the report, to the entry of the same
+// name if the phase already ran
+InstrumentPhase::~InstrumentPhase()
+{
+   if(!on)
+   {
+      return;
+   }
+   PhaseCounters end;
+   snapshot(end);
+   std::lock_guard<std::mutex> lock(reportMutex);
+   int i = 0;
+   while(i < (int)collecting.phases.size() && collecting.phases[i].name != name)
+   {
+      i++;
+   }
+   if(i == (int)collecting.phases.size())
+   {
+      collecting.phases.push_back(PhaseCounters());
+      collecting.phases[i].name = name;
+   }
+   PhaseCounters &phase = collecting.phases[i];
+   accumulate(start, end, phase);
+   phase.flops += flops;
+   phase.bytesMoved += bytesMoved;
+}
+
+// This function records the arithmetic and memory traffic of the phase
+void InstrumentPhase::count(int64_t flops, int64_t bytesMoved)
+{
+   this->flops += flops;
+   this->bytesMoved += bytesMoved;
+}
+
+// This function starts collecting a new report on the calling thread
+// Pre: no instrumentation is running
+// Post: Every phase that runs until stopInstrumentation is recorded
+void startInstrumentation(const std::string &algorithm, int n, bool hardware)
+{
+   {
+      std::lock_guard<std::mutex> lock(reportMutex);
+      collecting = InstrumentReport();
+      collecting.algorithm = algorithm;
+      collecting.n = n;
+      collecting.threads = getEvalThreads();
+   }
+   instrumentedThread = std::this_thread::get_id();
+   if(hardware)
+   {
+      openCounters();
+   }
+   {
+      //room for the phases up front, so growing the list is not counted
+      std::lock_guard<std::mutex> lock(reportMutex);
+      collecting.phases.reserve(16);
+   }
+   snapshot(totalStart);
+   instrumentationOn = true;
+}
+
+// This function stops collecting and hands over the report. The total
+// is measured around everything, its flops and bytes are the sum of the
+// phases.
+void stopInstrumentation(InstrumentReport &report)
+{
+   PhaseCounters end;
+   snapshot(end);
+   instrumentationOn = false;
+   closeCounters();
+   std::lock_guard<std::mutex> lock(reportMutex);
+   collecting.total = PhaseCounters();
+   collecting.total.name = "total";
+   accumulate(totalStart, end, collecting.total);
+   for(int i=0; i<(int)collecting.phases.size(); i++)
+   {
+      collecting.total.flops += collecting.phases[i].flops;
+      collecting.total.bytesMoved += collecting.phases[i].bytesMoved;
+   }
+   report = collecting;
+}
+
+// This function evaluates with the chosen algorithm and reports the flops,
+// allocations, bytes moved and, if asked for and available, hardware
+// counters of every phase
+// Pre: A vector of polynomials to evaluate at each of the roots of unity
+// Post: result holds the values, report what it took to compute them
+// Throws: -1 if no polynomial exists yet
+int instrumentEvaluation(EvalAlgorithm alg, std::vector<Poly> &polys, std::vector<Poly> &result,
+                         bool hardware, InstrumentReport &report)
+{
+   startInstrumentation(algorithmName(alg), polys.size(), hardware);
+   int retVal = runEvaluation(alg, polys, result);
+   stopInstrumentation(report);
+   return retVal;
+}
+
+static void printRow(std::ostream &out, const PhaseCounters &phase, bool hardware)
+{
+   out << std::left << std::setw(10) << phase.name << std::right << std::setw(6) << phase.calls
+       << std::setw(16) << phase.flops << std::setw(16) << phase.bytesMoved
+       << std::setw(8) << phase.allocations << std::setw(12) << phase.bytesAllocated
+       << std::setw(12) << std::fixed << std::setprecision(6) << phase.seconds;
+   if(hardware)
+   {
+      out << std::setw(14) << phase.cycles << std::setw(14) << phase.instructions
+          << std::setw(6) << std::setprecision(2) << phase.ipc() << std::setw(12) << phase.cacheMisses;
+   }
+   out.unsetf(std::ios::floatfield);
+   out << std::endl;
+}
+
+// This function prints the report as a table, the hardware columns only
+// when the counters could be read
+void InstrumentReport::print(std::ostream &out) const
+{
+   out << algorithm << " n=" << n << " threads=" << threads;
+   if(!total.hardware)
+   {
+      out << " (hardware counters unavailable)";
+   }
+   out << std::endl;
+   out << std::left << std::setw(10) << "phase" << std::right << std::setw(6) << "calls"
+       << std::setw(16) << "flops" << std::setw(16) << "bytes moved" << std::setw(8) << "allocs"
+       << std::setw(12) << "alloc bytes" << std::setw(12) << "seconds";
+   if(total.hardware)
+   {
+      out << std::setw(14) << "cycles" << std::setw(14) << "instructions" << std::setw(6) << "IPC"
+          << std::setw(12) << "cache miss";
+   }
+   out << std::endl;
+   for(int i=0; i<(int)phases.size(); i++)
+   {
+      printRow(out, phases[i], total.hardware);
+   }
+   printRow(out, total, total.hardware);
+}
+
+static void printJsonPhase(std::ostream &out, const PhaseCounters &phase)
+{
+   out << "{\"name\": \"" << phase.name << "\", \"calls\": " << phase.calls
+       << ", \"flops\": " << phase.flops << ", \"bytes_moved\": " << phase.bytesMoved
+       << ", \"allocations\": " << phase.allocations << ", \"bytes_allocated\": " << phase.bytesAllocated
+       << ", \"seconds\": " << std::setprecision(9) << phase.seconds;
+   if(phase.hardware)
+   {
+      out << ", \"cycles\": " << phase.cycles << ", \"instructions\": " << phase.instructions
+          << ", \"ipc\": " << phase.ipc() << ", \"cache_misses\": " << phase.cacheMisses;
+   }
+   out << "}";
+}
+
+// This function prints the report as one JSON object
+void InstrumentReport::printJson(std::ostream &out) const
+{
+   out << "{\"algorithm\": \"" << algorithm << "\", \"n\": " << n << ", \"threads\": " << threads
+       << ", \"hardware\": " << (total.hardware ? "true" : "false") << ", \"phases\": [";
+   for(int i=0; i<(int)phases.size(); i++)
+   {
+      out << (i == 0 ? "" : ", ");
+      printJsonPhase(out, phases[i]);
+   }
+   out << "], \"total\": ";
+   printJsonPhase(out, total);
+   out << "}" << std::endl;
+}
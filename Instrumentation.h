@@ -0,0 +1,78 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// What was measured over one phase of an evaluation, summed over every time
+// the phase ran. Flops and bytes moved are exact counts of the arithmetic
+// and the array loads and stores the code does, worked out from its loop
+// structure. In float and double-double they count operations on and
+// bytes of that type, a double-double operation is some ten to twenty
+// double ones. Allocations are the workspace blocks and aligned buffers
+// allocated while the phase ran, and every heap allocation when built with
+// -DCOUNT_ALL_ALLOCATIONS. The hardware counters are read from perf_event
+// for the thread that started the instrumentation, when the kernel allows it.
+struct PhaseCounters
+{
+   std::string name;
+   int calls;
+   int64_t flops;
+   int64_t bytesMoved;
+   int64_t allocations;
+   int64_t bytesAllocated;
+   double seconds;
+   bool hardware;
+   int64_t cycles;
+   int64_t instructions;
+   int64_t cacheMisses;
+   PhaseCounters();
+   double ipc() const;
+};
+
+// The phases of one instrumented evaluation in the order they first ran,
+// and the whole evaluation
+struct InstrumentReport
+{
+   std::string algorithm;
+   int n;
+   int threads;
+   std::vector<PhaseCounters> phases;
+   PhaseCounters total;
+   void print(std::ostream &out) const;
+   void printJson(std::ostream &out) const;
+};
+
+// Marks a phase of an evaluation from construction to destruction. When no
+// instrumentation is running it does nothing but test one flag, so phases
+// stay in the production code paths.
+class InstrumentPhase
+{
+   private:
+      const char *name;
+      bool on;
+      int64_t flops;
+      int64_t bytesMoved;
+      PhaseCounters start;
+
+   public:
+      InstrumentPhase(const char *name);
+      ~InstrumentPhase();
+      bool active() const { return on; }
+      void count(int64_t flops, int64_t bytesMoved);
+};
+
+extern std::atomic<bool> instrumentationOn;
+
+inline bool instrumenting()
+{
+   return instrumentationOn.load(std::memory_order_relaxed);
+}
+
+void countAllocation(size_t bytes);
+void startInstrumentation(const std::string &algorithm, int n, bool hardware);
+void stopInstrumentation(InstrumentReport &report);
+#endif
@@ -0,0 +1,89 @@
+#ifndef MONTGOMERY_H
+#define MONTGOMERY_H
+#include <stdint.h>
+
+// Arithmetic modulo an odd p < 2^62 in Montgomery form, where a is kept as
+// a*2^64 mod p. A product is reduced with two multiplies and a shift
+// instead of a 128 bit division. Values are only reduced lazily: every
+// operation takes and gives values below 2p, and the headroom up to 2^64
+// lets the NTT butterflies skip most of the comparisons a full reduction
+// would need. reduce brings a value below p when it is read out.
+struct Montgomery
+{
+   uint64_t p;
+   uint64_t twoP;
+   uint64_t pInv;      //-p^-1 mod 2^64
+   uint64_t rSquared;  //2^128 mod p, turns a into a*2^64 mod p
+
+   Montgomery() : p(0), twoP(0), pInv(0), rSquared(0) {}
+   Montgomery(uint64_t p) : p(p), twoP(2*p)
+   {
+      //Newton's iteration doubles the correct low bits of p^-1 every step
+      uint64_t inv = p;
+      for(int i=0; i<6; i++)
+      {
+         inv *= 2 - p*inv;
+      }
+      pInv = (~inv) + 1;
+      unsigned __int128 r = ((unsigned __int128)1 << 64) % p;
+      rSquared = (uint64_t)(r*r % p);
+   }
+
+   // t*2^-64 mod p, below 2p, for any t < p*2^64
+   uint64_t redc(unsigned __int128 t) const
+   {
+      uint64_t m = (uint64_t)t * pInv;
+      return (uint64_t)((t + (unsigned __int128)m*p) >> 64);
+   }
+
+   // a*b in Montgomery form, for a and b below 2p
+   uint64_t mul(uint64_t a, uint64_t b) const
+   {
+      return redc((unsigned __int128)a*b);
+   }
+
+   // a + b and a - b below 2p, for a and b below 2p
+   uint64_t add(uint64_t a, uint64_t b) const
+   {
+      uint64_t s = a + b;
+      return s >= twoP ? s - twoP : s;
+   }
+   uint64_t sub(uint64_t a, uint64_t b) const
+   {
+      uint64_t s = a + twoP - b;
+      return s >= twoP ? s - twoP : s;
+   }
+
+   // a below p, for a below 2p
+   uint64_t reduce(uint64_t a) const
+   {
+      return a >= p ? a - p : a;
+   }
+
+   // a < p into and out of Montgomery form
+   uint64_t toMontgomery(uint64_t a) const
+   {
+      return mul(a, rSquared);
+   }
+   uint64_t fromMontgomery(uint64_t a) const
+   {
+      return reduce(redc(a));
+   }
+
+   // a^e in Montgomery form by repeated squaring
+   uint64_t power(uint64_t a, uint64_t e) const
+   {
+      uint64_t result = toMontgomery(1);
+      while(e > 0)
+      {
+         if(e & 1)
+         {
+            result = mul(result, a);
+         }
+         a = mul(a, a);
+         e >>= 1;
+      }
+      return result;
+   }
+};
+#endif
@@ -0,0 +1,223 @@
+#include "AlgImpl.h"
+#include <chrono>
+#include <atomic>
+
+// Polynomial multiplication. Short operands are multiplied directly, longer
+// ones by convolution: both are zero padded to a transform size of at least
+// na+nb-1 points, transformed with fft, multiplied pointwise and transformed
+// back. The degree where one starts beating the other depends on the
+// machine. The defaults were measured on the development machine, and
+// tuneMultiplyCrossover measures them again when asked to.
+
+//smaller operand size at or below which the schoolbook product is used,
+//for complex operands [0] and real ones [1]
+static std::atomic<int> multiplyCrossover[2] = {{128}, {48}};
+
+// This function picks the transform size for a product of len coefficients,
+// the next power of two. A 3*2^k size pads less but the mixed radix
+// transform over it measured slower than the larger radix-2 one.
+// Pre: len > 0
+int convolutionSize(int len)
+{
+   int size = 1;
+   while(size < len)
+   {
+      size <<= 1;
+   }
+   return size;
+}
+
+// This function multiplies two polynomials the direct way, O(na*nb). The
+// coefficients are split into real and imaginary arrays first so the inner
+// loop runs over contiguous doubles.
+// Pre: a, b - na and nb > 0 coefficients, out - room for na+nb-1
+// Post: out holds the coefficients of a*b
+void schoolbookMultiply(const Poly *a, int na, const Poly *b, int nb, Poly *out)
+{
+   static thread_local PolySoA splitA, splitB, product;
+   splitA.resize(na);
+   splitB.resize(nb);
+   product.resize(na+nb-1);
+   for(int i=0; i<na; i++)
+   {
+      Poly value = a[i];
+      splitA.set(i, value.getReal(), value.getImag());
+   }
+   for(int j=0; j<nb; j++)
+   {
+      Poly value = b[j];
+      splitB.set(j, value.getReal(), value.getImag());
+   }
+   double *__restrict__ outR = product.realData();
+   double *__restrict__ outI = product.imagData();
+   const double *__restrict__ bR = splitB.realData();
+   const double *__restrict__ bI = splitB.imagData();
+   std::fill(outR, outR+na+nb-1, 0.0);
+   std::fill(outI, outI+na+nb-1, 0.0);
+   for(int i=0; i<na; i++)
+   {
+      double aR = splitA.getReal(i);
+      double aI = splitA.getImag(i);
+      for(int j=0; j<nb; j++)
+      {
+         outR[i+j] += aR*bR[j] - aI*bI[j];
+         outI[i+j] += aR*bI[j] + aI*bR[j];
+      }
+   }
+   for(int k=0; k<na+nb-1; k++)
+   {
+      out[k] = Poly(outR[k], outI[k]);
+   }
+}
+
+// This function multiplies two polynomials by FFT convolution in
+// O((na+nb) log(na+nb)). When both are real they share one transform as
+// z = a + i*b: with Z[k] and Z[-k] the transforms of a and b are
+// (Z[k] + conj(Z[-k]))/2 and (Z[k] - conj(Z[-k]))/2i, so their product is
+// (Z[k]^2 - conj(Z[-k])^2)/4i and the result needs one inverse transform.
+// Complex operands take two forward transforms and one inverse.
+// Pre: a, b - na and nb > 0 coefficients, out - room for na+nb-1
+// Post: out holds the coefficients of a*b
+void fftMultiply(const Poly *a, int na, const Poly *b, int nb, Poly *out)
+{
+   static thread_local std::vector<Poly> transformA, transformB;
+   int len = na+nb-1;
+   int m = convolutionSize(len);
+   transformA.assign(m, Poly(0, 0));
+   if(isRealPoly(a, na) && isRealPoly(b, nb))
+   {
+      for(int j=0; j<na; j++)
+      {
+         transformA[j].setReal(Poly(a[j]).getReal());
+      }
+      for(int j=0; j<nb; j++)
+      {
+         transformA[j].setImag(Poly(b[j]).getReal());
+      }
+      fft(transformA);
+      transformB.resize(m);
+      for(int k=0; k<m; k++)
+      {
+         Poly z = transformA[k];
+         Poly zNeg = transformA[k == 0 ? 0 : m-k];
+         double zR = z.getReal(), zI = z.getImag();
+         double nR = zNeg.getReal(), nI = (-1)*zNeg.getImag();
+         double dR = (zR*zR - zI*zI) - (nR*nR - nI*nI);
+         double dI = 2*zR*zI - 2*nR*nI;
+         //divide by 4i
+         transformB[k] = Poly(dI/4, (-1)*dR/4);
+      }
+      inverseFFT(transformB);
+      for(int k=0; k<len; k++)
+      {
+         out[k] = Poly(transformB[k].getReal(), 0);
+      }
+      return;
+   }
+
+   transformB.assign(m, Poly(0, 0));
+   std::copy(a, a+na, transformA.begin());
+   std::copy(b, b+nb, transformB.begin());
+   fft(transformA);
+   fft(transformB);
+   for(int k=0; k<m; k++)
+   {
+      double aR = transformA[k].getReal(), aI = transformA[k].getImag();
+      double bR = transformB[k].getReal(), bI = transformB[k].getImag();
+      transformA[k] = Poly(aR*bR - aI*bI, aR*bI + aI*bR);
+   }
+   inverseFFT(transformA);
+   std::copy(transformA.begin(), transformA.begin()+len, out);
+}
+
+// This function times both products on n by n complex polynomials, or
+// real ones, for growing n and returns the last size where the schoolbook
+// product was still faster. Real operands share one transform in
+// fftMultiply, so their crossover is lower. Each time is the best of
+// several runs so a single interruption does not move the crossover. It
+// takes a few hundred milliseconds, so multiply never calls it on its own.
+// Post: Returns the crossover for this machine, pass it to
+//       setMultiplyCrossover to use it
+int tuneMultiplyCrossover(bool real)
+{
+   const int maxSize = 2048;
+   const int runs = 5;
+   std::vector<Poly> a(maxSize), b(maxSize), out(2*maxSize);
+   for(int i=0; i<maxSize; i++)
+   {
+      a[i] = Poly((i*7919)%19 - 9, real ? 0 : (i*104729)%23 - 11);
+      b[i] = Poly((i*7907)%17 - 8, real ? 0 : (i*3571)%13 - 6);
+   }
+   int crossover = 1;
+   for(int n=4; n<=maxSize; n += n/4)
+   {
+      double best[2] = {1e300, 1e300};
+      for(int method=0; method<2; method++)
+      {
+         for(int run=0; run<runs; run++)
+         {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if(method == 0)
+            {
+               schoolbookMultiply(&a[0], n, &b[0], n, &out[0]);
+            }
+            else
+            {
+               fftMultiply(&a[0], n, &b[0], n, &out[0]);
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best[method] = std::min(best[method], elapsed.count());
+         }
+      }
+      if(best[1] < best[0])
+      {
+         break;
+      }
+      crossover = n;
+   }
+   return crossover;
+}
+
+// This function sets the crossover of real or complex operands, e.g. to
+// what tuneMultiplyCrossover measured
+// Pre: crossover > 0
+void setMultiplyCrossover(int crossover, bool real)
+{
+   multiplyCrossover[real] = crossover;
+}
+
+// This function returns the crossover of real or complex operands
+int getMultiplyCrossover(bool real)
+{
+   return multiplyCrossover[real];
+}
+
+// This function multiplies two polynomials with real or complex
+// coefficients, using the schoolbook product when the shorter one is at or
+// below the crossover for their kind and FFT convolution otherwise
+// Pre: a, b - coefficients in increasing degree
+//      result - a vector to store the product in
+// Post: result holds the na+nb-1 coefficients of a*b
+// Throws: -1 if either polynomial is empty
+int multiply(const std::vector<Poly> &a, const std::vector<Poly> &b, std::vector<Poly> &result)
+{
+   if(a.empty() || b.empty())
+   {
+      return -1;
+   }
+   int na = a.size(), nb = b.size();
+   //result may be one of the inputs, so the product is built on the side
+   static thread_local std::vector<Poly> product;
+   product.resize(na+nb-1);
+   bool real = isRealPoly(&a[0], na) && isRealPoly(&b[0], nb);
+   if(std::min(na, nb) <= getMultiplyCrossover(real))
+   {
+      schoolbookMultiply(&a[0], na, &b[0], nb, &product[0]);
+   }
+   else
+   {
+      fftMultiply(&a[0], na, &b[0], nb, &product[0]);
+   }
+   result.assign(product.begin(), product.end());
+   return 0;
+}
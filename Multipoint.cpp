@@ -0,0 +1,316 @@
+#include "AlgImpl.h"
+#include <cfloat>
+
+// Evaluation at arbitrary points. The points are multiplied up into a
+// subproduct tree, whose leaves are the products of (x - p) over small
+// groups of points and whose every other node is the product of its two
+// children. The polynomial is reduced modulo the root, each remainder
+// modulo both children and so on down, so a leaf is left with a remainder
+// of the leaf's degree that agrees with the polynomial at its points, and
+// horner finishes there. Products and divisions go through multiply, so
+// the whole is O(n log^2 n).
+//
+// In floating point the tree is only usable while its polynomials have
+// coefficients of moderate size. Points taken in the order given (or
+// sorted) make a node of nearby points, whose product has coefficients
+// that grow exponentially with its degree. So the points are sorted by
+// angle and dealt out like the bit reversal permutation: every node then
+// holds points spread evenly around the origin, and for points near the
+// unit circle its product stays close to x^k - c. That keeps the tree
+// usable for structured point sets such as rotated or scaled
+// roots of unity. For points scattered at random, even on the unit circle,
+// the reversed tree polynomials have power series inverses whose
+// coefficients grow like k^(d-1) for a node of degree d, and the
+// remainders lose all accuracy. Even the structured sets are not exact:
+// every remainder subtracts a product rounded relative to the size of its
+// factors, and by 20k points on the unit circle the values are off by
+// about 1e-10 of sum |a_i| |p|^i where horner is off by about 1e-16.
+//
+// The fast values are therefore only kept where they are as good as
+// horner's. One point of every leaf is checked against horner, and a
+// leaf that does not agree to a few ulps of sum |a_i| |p|^i has all its
+// points redone with horner. A probe point checked at every level of the
+// descent drops the tree as soon as it goes wrong, after the tree and one
+// level of remainders were paid for. So the worst case is horner's O(nm)
+// plus that much, and the checks add O(n) per leaf, about n*m/20, to a
+// tree that is kept.
+
+//most points per leaf of the subproduct tree, leaves are finished with horner
+static const int multipointLeafSize = 32;
+//horner is used throughout when the polynomial or the point set is this
+//small, the tree only won from about 32k points by 32k coefficients
+static const int multipointCutoff = 16384;
+//error a fast value may have, relative to sum |a_i| |p|^i at its point
+static const double multipointTolerance = 8*DBL_EPSILON;
+
+// This function deals the angle sorted points out to groups leaves, a
+// power of two, the way the bit reversal permutation would: leaf g gets
+// every groups-th point starting at bitreverse(g). Two neighbouring leaves
+// then hold every groups/2-th point between them, and so on up the tree.
+// Post: order lists the point indices leaf by leaf, leaf g starting at
+//       leafStart[g]
+static void spreadOrder(const std::vector<int> &sorted, int groups, std::vector<int> &order, std::vector<int> &leafStart)
+{
+   int m = sorted.size();
+   order.clear();
+   leafStart.resize(groups+1);
+   for(int g=0, r=0; g<groups; g++)
+   {
+      leafStart[g] = order.size();
+      for(int i=r; i<m; i+=groups)
+      {
+         order.push_back(sorted[i]);
+      }
+      //next bit reversed index
+      int bit = groups >> 1;
+      for(; r & bit; bit >>= 1)
+      {
+         r ^= bit;
+      }
+      r ^= bit;
+   }
+   leafStart[groups] = m;
+}
+
+static Poly complexMultiply(Poly a, Poly b)
+{
+   return Poly((a.getReal()*b.getReal()) + ((-1)*a.getImag()*b.getImag()),
+               (a.getReal()*b.getImag()) + (a.getImag()*b.getReal()));
+}
+
+// This function computes the power series inverse of p to k terms by
+// Newton iteration, h <- h*(2 - p*h), doubling the number of correct terms
+// every step
+// Pre: p[0] != 0, k > 0
+// Post: p*inverse = 1 mod x^k
+static void inverseSeries(const std::vector<Poly> &p, int k, std::vector<Poly> &inverse)
+{
+   Poly p0 = p[0];
+   double p0Real = p0.getReal(), p0Imag = p0.getImag();
+   double norm = p0Real*p0Real + p0Imag*p0Imag;
+   inverse.assign(1, Poly(p0Real/norm, (-1)*p0Imag/norm));
+   std::vector<Poly> prefix, error;
+   for(int terms=1; terms<k; )
+   {
+      terms = std::min(2*terms, k);
+      prefix.assign(p.begin(), p.begin() + std::min<int>(terms, p.size()));
+      multiply(prefix, inverse, error);
+      error.resize(terms, Poly(0, 0));
+      for(int i=0; i<terms; i++)
+      {
+         error[i] = Poly((-1)*error[i].getReal(), (-1)*error[i].getImag());
+      }
+      error[0].setReal(error[0].getReal() + 2);
+      multiply(inverse, error, inverse);
+      inverse.resize(terms);
+   }
+}
+
+// This function divides f by the monic g and keeps the remainder. With
+// reversed coefficients the quotient is a power series product, rev(q) =
+// rev(f) * rev(g)^-1 mod x^(deg f - deg g + 1), so the division costs two
+// multiplications and a series inverse.
+// Pre: g - monic, size >= 2
+// Post: r holds f mod g, size(g)-1 coefficients or fewer when f is shorter
+static void polyRemainder(const std::vector<Poly> &f, const std::vector<Poly> &g, std::vector<Poly> &r)
+{
+   int a = f.size(), b = g.size();
+   if(a < b)
+   {
+      r.assign(f.begin(), f.end());
+      return;
+   }
+   int q = a-b+1;
+   std::vector<Poly> revF(q), revG(std::min(q, b)), inverse, quotient;
+   for(int i=0; i<q; i++)
+   {
+      revF[i] = f[a-1-i];
+   }
+   for(int i=0; i<(int)revG.size(); i++)
+   {
+      revG[i] = g[b-1-i];
+   }
+   inverseSeries(revG, q, inverse);
+   multiply(revF, inverse, quotient);
+   quotient.resize(q);
+   std::reverse(quotient.begin(), quotient.end());
+
+   multiply(quotient, g, quotient);
+   r.resize(b-1);
+   for(int i=0; i<b-1; i++)
+   {
+      Poly fi = f[i];
+      r[i] = Poly(fi.getReal() - quotient[i].getReal(), fi.getImag() - quotient[i].getImag());
+   }
+}
+
+// This function tells whether got is within multipointTolerance of the
+// horner value expected at point, relative to sum |a_i| |p|^i, the size of
+// the terms horner adds up there
+static bool closeEnough(const std::vector<Poly> &polys, Poly point, Poly got, Poly expected)
+{
+   double radius = hypot(point.getReal(), point.getImag());
+   double scale = 0;
+   for(int i=polys.size()-1; i>=0; i--)
+   {
+      Poly a = polys[i];
+      scale = scale*radius + hypot(a.getReal(), a.getImag());
+   }
+   double error = hypot(got.getReal() - expected.getReal(), got.getImag() - expected.getImag());
+   return error <= multipointTolerance*scale;
+}
+
+// This function evaluates a polynomial at m caller supplied points, with the
+// subproduct tree when both the polynomial and the point set are large and
+// with horner otherwise or wherever the tree turns out inaccurate
+// Pre: polys - the coefficients of the polynomial
+//      points - where to evaluate it
+//      result - a vector to store the values in
+// Post: result[i] holds the polynomial evaluated at points[i]
+// Throws: -1 if no polynomial exists yet
+int evalAtPoints(const std::vector<Poly> &polys, const std::vector<Poly> &points, std::vector<Poly> &result)
+{
+   int n = polys.size();
+   int m = points.size();
+   if(n == 0)
+   {
+      return -1;
+   }
+   if(std::min(n, m) <= multipointCutoff)
+   {
+      return hornerEvalAt(polys, points, result);
+   }
+
+   //tree order of the points, spread by angle
+   std::vector<Poly> spread(m);
+   std::vector<int> sorted(m), order;
+   std::vector<double> angle(m);
+   for(int i=0; i<m; i++)
+   {
+      Poly p = points[i];
+      angle[i] = atan2(p.getImag(), p.getReal());
+      sorted[i] = i;
+   }
+   std::sort(sorted.begin(), sorted.end(), [&](int x, int y) { return angle[x] < angle[y]; });
+   int groups = 1;
+   while(groups*multipointLeafSize < m)
+   {
+      groups <<= 1;
+   }
+   std::vector<int> leafStart;
+   spreadOrder(sorted, groups, order, leafStart);
+   for(int i=0; i<m; i++)
+   {
+      spread[i] = points[order[i]];
+   }
+
+   //leaves, the product of (x - p) over each group of points, a power of
+   //two of them so every node has two children
+   std::vector<std::vector<std::vector<Poly> > > tree(1, std::vector<std::vector<Poly> >(groups));
+   parallelFor(0, groups, [&](int gBegin, int gEnd)
+   {
+      for(int g=gBegin; g<gEnd; g++)
+      {
+         std::vector<Poly> &leaf = tree[0][g];
+         leaf.assign(1, Poly(1, 0));
+         for(int i=leafStart[g]; i<leafStart[g+1]; i++)
+         {
+            //leaf <- leaf*(x - p)
+            Poly p = spread[i];
+            leaf.push_back(Poly(0, 0));
+            for(int j=leaf.size()-1; j>=0; j--)
+            {
+               Poly shifted = j > 0 ? leaf[j-1] : Poly(0, 0);
+               Poly scaled = complexMultiply(leaf[j], p);
+               leaf[j] = Poly(shifted.getReal() - scaled.getReal(), shifted.getImag() - scaled.getImag());
+            }
+         }
+      }
+   });
+   while(tree.back().size() > 1)
+   {
+      const std::vector<std::vector<Poly> > &below = tree.back();
+      std::vector<std::vector<Poly> > level(below.size()/2);
+      parallelFor(0, level.size(), [&](int begin, int end)
+      {
+         for(int i=begin; i<end; i++)
+         {
+            multiply(below[2*i], below[2*i+1], level[i]);
+         }
+      });
+      tree.push_back(level);
+   }
+
+   //remainders down the tree, each level replaces the one above. The first
+   //point lies under the first node of every level, so watching the value
+   //there catches a tree gone unstable before the lower levels are paid for.
+   std::vector<Poly> probe(1, spread[0]), expected, value;
+   hornerEvalAt(polys, probe, expected);
+   std::vector<std::vector<Poly> > remainders(1);
+   polyRemainder(polys, tree.back()[0], remainders[0]);
+   for(int depth=tree.size()-2; depth>=-1; depth--)
+   {
+      hornerEvalAt(remainders[0], probe, value);
+      if(!closeEnough(polys, probe[0], value[0], expected[0]))
+      {
+         return hornerEvalAt(polys, points, result);
+      }
+      if(depth < 0)
+      {
+         break;
+      }
+      std::vector<std::vector<Poly> > next(tree[depth].size());
+      parallelFor(0, next.size(), [&](int begin, int end)
+      {
+         for(int i=begin; i<end; i++)
+         {
+            polyRemainder(remainders[i/2], tree[depth][i], next[i]);
+         }
+      });
+      remainders.swap(next);
+   }
+
+   //leaves, each checked at its first point and redone with horner when
+   //its remainder went wrong
+   result.resize(m);
+   parallelFor(0, groups, [&](int gBegin, int gEnd)
+   {
+      for(int g=gBegin; g<gEnd; g++)
+      {
+         int first = leafStart[g];
+         std::vector<Poly> leafPoints(spread.begin()+first, spread.begin()+leafStart[g+1]);
+         std::vector<Poly> values, check(1, leafPoints[0]), checkValue;
+         hornerEvalAt(remainders[g], leafPoints, values);
+         hornerEvalAt(polys, check, checkValue);
+         if(!closeEnough(polys, check[0], values[0], checkValue[0]))
+         {
+            hornerEvalAt(polys, leafPoints, values);
+         }
+         for(int i=0; i<(int)values.size(); i++)
+         {
+            result[order[first+i]] = values[i];
+         }
+      }
+   });
+   return 0;
+}
+
+// This function evaluates a polynomial at m caller supplied points with
+// horners algorithm, O(nm)
+// Pre: polys - the coefficients of the polynomial
+//      points - where to evaluate it
+//      result - a vector to store the values in
+// Post: result[i] holds the polynomial evaluated at points[i]
+// Throws: -1 if no polynomial exists yet
+int hornerEvalAt(const std::vector<Poly> &polys, const std::vector<Poly> &points, std::vector<Poly> &result)
+{
+   if(polys.empty())
+   {
+      return -1;
+   }
+   PolySoA coeffs(polys), at(points), values(points.size());
+   hornerEvalAt(coeffs.realData(), coeffs.imagData(), coeffs.size(), at.realData(), at.imagData(), at.size(),
+                values.realData(), values.imagData());
+   values.toPolys(result);
+   return 0;
+}
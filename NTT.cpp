@@ -0,0 +1,359 @@
+#include "NTT.h"
+
+//values whose remaining butterfly passes are done together, 16 KB that stay
+//in the L1 cache while log2(nttBlock) passes go over them
+static const int nttBlock = 2048;
+//largest magnitude a double holds every integer up to
+static const double exactLimit = 9007199254740992.0; //2^53
+
+// This function does the decimation in frequency passes over blocks of
+// length block down to 2 on the block values at a. Every butterfly
+// takes and leaves values below 2p: the sum is reduced by one compare, the
+// difference is lifted by 2p and goes straight into the Montgomery multiply.
+static void forwardPasses(uint64_t *a, int block, const NTTPlan &plan)
+{
+   const Montgomery &f = plan.arithmetic();
+   for(int len=block; len>=2; len >>= 1)
+   {
+      int half = len/2;
+      const uint64_t *tw = plan.twiddle(len);
+      for(int start=0; start<block; start+=len)
+      {
+         for(int j=0; j<half; j++)
+         {
+            uint64_t u = a[start+j], v = a[start+j+half];
+            a[start+j] = f.add(u, v);
+            a[start+j+half] = f.mul(u + f.twoP - v, tw[j]);
+         }
+      }
+   }
+}
+
+// This function does the decimation in time passes over blocks of length 2
+// up to len on the block of len values at a, the inverse of forwardPasses
+// with the inverse twiddles
+static void inversePasses(uint64_t *a, int len, const NTTPlan &plan)
+{
+   const Montgomery &f = plan.arithmetic();
+   for(int cur=2; cur<=len; cur <<= 1)
+   {
+      int half = cur/2;
+      const uint64_t *tw = plan.inverseTwiddle(cur);
+      for(int start=0; start<len; start+=cur)
+      {
+         for(int j=0; j<half; j++)
+         {
+            uint64_t u = a[start+j];
+            uint64_t v = f.mul(a[start+j+half], tw[j]);
+            a[start+j] = f.add(u, v);
+            a[start+j+half] = f.sub(u, v);
+         }
+      }
+   }
+}
+
+// This function is one pass over the whole buffer, the butterflies split
+// between the threads. Butterfly b is j = b mod half of block b/half.
+static void widePass(uint64_t *a, int n, int len, bool inverse, const NTTPlan &plan)
+{
+   const Montgomery &f = plan.arithmetic();
+   int half = len/2;
+   const uint64_t *tw = inverse ? plan.inverseTwiddle(len) : plan.twiddle(len);
+   parallelFor(0, n/2, [&](int bBegin, int bEnd)
+   {
+      for(int b=bBegin; b<bEnd; b++)
+      {
+         int j = b & (half-1);
+         int i = 2*b - j;
+         uint64_t u = a[i], v = a[i+half];
+         if(inverse)
+         {
+            v = f.mul(v, tw[j]);
+            a[i] = f.add(u, v);
+            a[i+half] = f.sub(u, v);
+         }
+         else
+         {
+            a[i] = f.add(u, v);
+            a[i+half] = f.mul(u + f.twoP - v, tw[j]);
+         }
+      }
+   });
+}
+
+// This function transforms n values in Montgomery form with the decimation
+// in frequency NTT, so the result comes out in bit reversed order, which
+// nttInverse takes directly and a convolution never has to reorder. The
+// passes over blocks longer than nttBlock go over the whole buffer, the
+// rest are done one block at a time while the block stays in the cache.
+// Pre: a - plan.size() values below 2p, plan - the plan for size n
+// Post: a[rev(k)] holds sum over j of a_j * w^(jk), below 2p
+void nttForward(uint64_t *a, const NTTPlan &plan)
+{
+   int n = plan.size();
+   int len = n;
+   for(; len>nttBlock; len >>= 1)
+   {
+      widePass(a, n, len, false, plan);
+   }
+   parallelFor(0, n/len, [&](int blockBegin, int blockEnd)
+   {
+      for(int block=blockBegin; block<blockEnd; block++)
+      {
+         forwardPasses(a+(size_t)block*len, len, plan);
+      }
+   });
+}
+
+// This function is the inverse of nttForward without the division by n,
+// from bit reversed order back to natural order
+// Pre: a - plan.size() values below 2p in bit reversed order
+// Post: a[j] holds n times the jth coefficient, below 2p
+void nttInverse(uint64_t *a, const NTTPlan &plan)
+{
+   int n = plan.size();
+   int len = std::min(n, nttBlock);
+   parallelFor(0, n/len, [&](int blockBegin, int blockEnd)
+   {
+      for(int block=blockBegin; block<blockEnd; block++)
+      {
+         inversePasses(a+(size_t)block*len, len, plan);
+      }
+   });
+   for(len <<= 1; len<=n; len <<= 1)
+   {
+      widePass(a, n, len, true, plan);
+   }
+}
+
+// This function checks a coefficient is an integer a double holds exactly
+static bool isExactInteger(double x)
+{
+   return x == floor(x) && fabs(x) < exactLimit;
+}
+
+// This function gives x mod p in Montgomery form, most coefficients are
+// below p and need no division
+static uint64_t toResidue(int64_t x, const Montgomery &f)
+{
+   uint64_t magnitude = x < 0 ? -(uint64_t)x : (uint64_t)x;
+   if(magnitude >= f.p)
+   {
+      magnitude %= f.p;
+   }
+   return f.toMontgomery(x < 0 && magnitude != 0 ? f.p - magnitude : magnitude);
+}
+
+// This function evaluates a polynomial with integer coefficients exactly
+// modulo an NTT prime p at all n of its nth roots of unity, the powers of
+// the plan's root w
+// Pre: polys - n coefficients, integers below 2^53 in magnitude, imaginary
+//              parts 0, n a power of two
+//      prime - which NTT prime, 0 <= prime < nttPrimeCount
+// Post: values[k] holds the polynomial at w^k mod p, in [0, p)
+// Throws: -1 if no polynomial exists yet, n is not a power of two or a
+//         coefficient is not such an integer
+int nttEval(const std::vector<Poly> &polys, int prime, std::vector<uint64_t> &values)
+{
+   int n = polys.size();
+   if(n == 0 || (n & (n-1)) != 0 || prime < 0 || prime >= nttPrimeCount)
+   {
+      return -1;
+   }
+   std::shared_ptr<const NTTPlan> plan = getNTTPlan(prime, n);
+   const Montgomery &f = plan->arithmetic();
+   WorkspaceFrame frame;
+   uint64_t *a = frame.allocate<uint64_t>(n);
+   for(int j=0; j<n; j++)
+   {
+      Poly c = polys[j];
+      if(!isExactInteger(c.getReal()) || c.getImag() != 0)
+      {
+         return -1;
+      }
+      a[j] = toResidue(c.getReal(), f);
+   }
+   nttForward(a, *plan);
+   values.resize(n);
+   //k counts up while r counts up in bit reversed order
+   for(int k=0, r=0; k<n; k++)
+   {
+      values[k] = f.fromMontgomery(a[r]);
+      int bit = n >> 1;
+      while(bit > 0 && (r & bit))
+      {
+         r ^= bit;
+         bit >>= 1;
+      }
+      r |= bit;
+   }
+   return 0;
+}
+
+// This function convolves a and b modulo one NTT prime, the coefficients of
+// a*b mod p in [0, p)
+static void convolveModulo(const int64_t *a, int na, const int64_t *b, int nb, int prime, uint64_t *out)
+{
+   int size = convolutionSize(na+nb-1);
+   std::shared_ptr<const NTTPlan> plan = getNTTPlan(prime, size);
+   const Montgomery &f = plan->arithmetic();
+   WorkspaceFrame frame;
+   uint64_t *fa = frame.allocate<uint64_t>(size);
+   uint64_t *fb = frame.allocate<uint64_t>(size);
+   for(int i=0; i<size; i++)
+   {
+      fa[i] = toResidue(i < na ? a[i] : 0, f);
+      fb[i] = toResidue(i < nb ? b[i] : 0, f);
+   }
+   nttForward(fa, *plan);
+   nttForward(fb, *plan);
+   uint64_t scale = plan->getScale();
+   parallelFor(0, size, [&](int kBegin, int kEnd)
+   {
+      for(int k=kBegin; k<kEnd; k++)
+      {
+         fa[k] = f.mul(f.mul(fa[k], fb[k]), scale);
+      }
+   });
+   nttInverse(fa, *plan);
+   for(int k=0; k<na+nb-1; k++)
+   {
+      out[k] = f.fromMontgomery(fa[k]);
+   }
+}
+
+// This function multiplies two polynomials with integer coefficients
+// exactly. The product is convolved modulo as many NTT primes as its
+// coefficients need: with |c| <= min(na,nb)*max|a|*max|b| below p/2 one
+// prime determines c, otherwise the residues modulo two primes are put
+// together with Garner's form of the Chinese remainder theorem,
+//    c = r0 + p0 * ((r1 - r0) * p0^-1 mod p1)
+// taken from [0, p0*p1) to the symmetric range.
+// Pre: a, b - na and nb > 0 coefficients, out - room for na+nb-1
+// Post: out holds the coefficients of a*b
+// Throws: -1 if either polynomial is empty or the bound on the product's
+//         coefficients does not fit 63 bits
+int nttMultiply(const int64_t *a, int na, const int64_t *b, int nb, int64_t *out)
+{
+   if(na <= 0 || nb <= 0)
+   {
+      return -1;
+   }
+   unsigned __int128 maxA = 0, maxB = 0;
+   for(int i=0; i<na; i++)
+   {
+      maxA = std::max(maxA, (unsigned __int128)(a[i] < 0 ? -(uint64_t)a[i] : (uint64_t)a[i]));
+   }
+   for(int j=0; j<nb; j++)
+   {
+      maxB = std::max(maxB, (unsigned __int128)(b[j] < 0 ? -(uint64_t)b[j] : (uint64_t)b[j]));
+   }
+   //compared as long double, the bound itself may overflow 128 bits
+   long double bound = (long double)maxA * (long double)maxB * std::min(na, nb);
+   if(bound >= 9223372036854775807.0L)
+   {
+      return -1;
+   }
+   int len = na+nb-1;
+   WorkspaceFrame frame;
+   uint64_t *r0 = frame.allocate<uint64_t>(len);
+   convolveModulo(a, na, b, nb, 0, r0);
+   uint64_t p0 = nttModulus(0);
+   if(bound < p0/2)
+   {
+      for(int k=0; k<len; k++)
+      {
+         out[k] = r0[k] <= p0/2 ? (int64_t)r0[k] : (int64_t)r0[k] - (int64_t)p0;
+      }
+      return 0;
+   }
+   uint64_t *r1 = frame.allocate<uint64_t>(len);
+   convolveModulo(a, na, b, nb, 1, r1);
+   Montgomery f1(nttModulus(1));
+   //p0^-1 mod p1 by Fermat, kept in Montgomery form so one mul gives the plain product
+   uint64_t p0Inverse = f1.power(f1.toMontgomery(p0), f1.p-2);
+   unsigned __int128 both = (unsigned __int128)p0 * f1.p;
+   for(int k=0; k<len; k++)
+   {
+      //r0 < p0 < p1 already
+      uint64_t diff = r1[k] >= r0[k] ? r1[k] - r0[k] : r1[k] + f1.p - r0[k];
+      uint64_t t = f1.reduce(f1.mul(diff, p0Inverse));
+      unsigned __int128 c = r0[k] + (unsigned __int128)p0 * t;
+      out[k] = c <= both/2 ? (int64_t)c : -(int64_t)(both - c);
+   }
+   return 0;
+}
+
+// This function multiplies two polynomials with Gaussian integer
+// coefficients exactly. The real and imaginary parts are multiplied apart
+// with nttMultiply, four products, or one when both are real.
+// Pre: a, b - coefficients in increasing degree, integers below 2^53 in
+//             magnitude in both parts
+//      result - a vector to store the product in
+// Post: result holds the na+nb-1 coefficients of a*b, rounded only if one
+//       lies beyond 2^53
+// Throws: -1 if either polynomial is empty, a coefficient is not such an
+//         integer or the product's coefficients may not fit 63 bits
+int multiplyExact(const std::vector<Poly> &a, const std::vector<Poly> &b, std::vector<Poly> &result)
+{
+   if(a.empty() || b.empty())
+   {
+      return -1;
+   }
+   int na = a.size(), nb = b.size(), len = na+nb-1;
+   WorkspaceFrame frame;
+   int64_t *aReal = frame.allocate<int64_t>(na), *aImag = frame.allocate<int64_t>(na);
+   int64_t *bReal = frame.allocate<int64_t>(nb), *bImag = frame.allocate<int64_t>(nb);
+   bool complex = false;
+   for(int i=0; i<na; i++)
+   {
+      Poly c = a[i];
+      if(!isExactInteger(c.getReal()) || !isExactInteger(c.getImag()))
+      {
+         return -1;
+      }
+      aReal[i] = c.getReal();
+      aImag[i] = c.getImag();
+      complex = complex || aImag[i] != 0;
+   }
+   for(int j=0; j<nb; j++)
+   {
+      Poly c = b[j];
+      if(!isExactInteger(c.getReal()) || !isExactInteger(c.getImag()))
+      {
+         return -1;
+      }
+      bReal[j] = c.getReal();
+      bImag[j] = c.getImag();
+      complex = complex || bImag[j] != 0;
+   }
+   int64_t *real = frame.allocate<int64_t>(len);
+   if(nttMultiply(aReal, na, bReal, nb, real) < 0)
+   {
+      return -1;
+   }
+   result.resize(len);
+   if(!complex)
+   {
+      for(int k=0; k<len; k++)
+      {
+         result[k] = Poly(real[k], 0);
+      }
+      return 0;
+   }
+   //(ar + i*ai)(br + i*bi) = ar*br - ai*bi + i*(ar*bi + ai*br), summed in
+   //128 bits since two products in range may add up past 63
+   int64_t *realImag = frame.allocate<int64_t>(len);
+   int64_t *imagReal = frame.allocate<int64_t>(len);
+   int64_t *imagImag = frame.allocate<int64_t>(len);
+   if(nttMultiply(aImag, na, bImag, nb, imagImag) < 0 || nttMultiply(aReal, na, bImag, nb, realImag) < 0 ||
+      nttMultiply(aImag, na, bReal, nb, imagReal) < 0)
+   {
+      return -1;
+   }
+   for(int k=0; k<len; k++)
+   {
+      result[k] = Poly((double)((__int128)real[k] - imagImag[k]), (double)((__int128)realImag[k] + imagReal[k]));
+   }
+   return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef NTT_H
+#define NTT_H
+#include "AlgImpl.h"
+
+// Exact integer evaluation and multiplication with the number theoretic
+// transform, the FFT over the integers modulo a prime p = c*2^k + 1 instead
+// of the complex numbers. Its roots of unity are integers mod p, so no step
+// rounds. Products whose coefficients could reach past one prime are put
+// together from two primes with the Chinese remainder theorem.
+
+void nttForward(uint64_t*, const NTTPlan&);
+void nttInverse(uint64_t*, const NTTPlan&);
+int nttEval(const std::vector<Poly>&, int, std::vector<uint64_t>&);
+int nttMultiply(const int64_t*, int, const int64_t*, int, int64_t*);
+int multiplyExact(const std::vector<Poly>&, const std::vector<Poly>&, std::vector<Poly>&);
+#endif
@@ -0,0 +1,363 @@
+#include "PolyBinary.h"
+#include "Precision.h"
+#include <future>
+#include <functional>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// This function reads bytes at offset of a file, however many calls it takes
+// Post: Returns false if the file ended or could not be read
+static bool readAt(int fd, void *buffer, size_t bytes, uint64_t offset)
+{
+   char *next = static_cast<char*>(buffer);
+   while(bytes > 0)
+   {
+      ssize_t done = pread(fd, next, bytes, offset);
+      if(done <= 0)
+      {
+         return false;
+      }
+      next += done;
+      bytes -= done;
+      offset += done;
+   }
+   return true;
+}
+
+// This function writes bytes at offset of a file, however many calls it takes
+// Post: Returns false if the file could not be written
+static bool writeAt(int fd, const void *buffer, size_t bytes, uint64_t offset)
+{
+   const char *next = static_cast<const char*>(buffer);
+   while(bytes > 0)
+   {
+      ssize_t done = pwrite(fd, next, bytes, offset);
+      if(done <= 0)
+      {
+         return false;
+      }
+      next += done;
+      bytes -= done;
+      offset += done;
+   }
+   return true;
+}
+
+// This function reads count coefficients of a binary polynomial file from
+// first on, in either layout
+// Pre: stage - room for 2*count doubles, used for the split layout
+static bool readCoefficients(int fd, const PolyFileHeader &header, uint64_t first, int count,
+                             Poly *out, double *stage)
+{
+   if(header.layout == LAYOUT_INTERLEAVED)
+   {
+      return readAt(fd, out, count*sizeof(Poly), header.dataOffset + first*sizeof(Poly));
+   }
+   uint64_t imagOffset = header.dataOffset + header.count*sizeof(double);
+   if(!readAt(fd, stage, count*sizeof(double), header.dataOffset + first*sizeof(double)) ||
+      !readAt(fd, stage+count, count*sizeof(double), imagOffset + first*sizeof(double)))
+   {
+      return false;
+   }
+   for(int i=0; i<count; i++)
+   {
+      out[i] = Poly(stage[i], stage[count+i]);
+   }
+   return true;
+}
+
+// This function runs blocks through read, compute and write with three
+// buffers, so while block b is computed block b+1 is read ahead and block
+// b-1 is written behind on their own threads. A buffer is read into again
+// only after the write of the block it held has finished.
+// Throws: -2 if a read or a write failed
+static int pipeline(int blocks, Poly *buffers[3], const std::function<bool(int, Poly*)> &read,
+                    const std::function<void(int, Poly*)> &compute,
+                    const std::function<bool(int, Poly*)> &write)
+{
+   std::future<bool> reading = std::async(std::launch::async, read, 0, buffers[0]);
+   std::future<bool> writing;
+   bool ok = true;
+   for(int b=0; b<blocks && ok; b++)
+   {
+      ok = reading.get();
+      if(ok && b+1 < blocks)
+      {
+         reading = std::async(std::launch::async, read, b+1, buffers[(b+1)%3]);
+      }
+      if(ok)
+      {
+         compute(b, buffers[b%3]);
+      }
+      if(writing.valid())
+      {
+         ok = writing.get() && ok;
+      }
+      if(ok)
+      {
+         writing = std::async(std::launch::async, write, b, buffers[b%3]);
+      }
+   }
+   if(reading.valid())
+   {
+      reading.wait();
+   }
+   if(writing.valid())
+   {
+      ok = writing.get() && ok;
+   }
+   return ok ? 0 : -2;
+}
+
+// This function evaluates a binary polynomial file at all n roots of unity
+// without ever holding the polynomial in memory. It is the four-step FFT of
+// fourStepFFT with the matrix x[j1*n2 + j2] on disk, n1 the largest divisor
+// of n up to sqrt(n):
+//    1. blocks of columns are read, transformed, twiddled by w^(j2*k1) and
+//       written to a scratch file one column after the other
+//    2. blocks of rows k1 are gathered from the scratch file, transformed,
+//       and X_(k1 + n1*k2) is written to its place in the output file
+// Both passes read the next block ahead and write the previous one behind
+// while a block is transformed. The block sizes come from memoryBudget,
+// which bounds the three block buffers, the plans and twiddle tables of
+// sizes n1 and n2 and the FFT scratch memory together, the operating
+// system's page cache aside. A polynomial that fits the budget several
+// times over is simply transformed in memory. The scratch file sits next
+// to the output and is removed as soon as it is opened, so it never outlives
+// the process.
+// Pre: inputFile - a binary polynomial file in either layout
+//      outputFile - file to create, memoryBudget - bytes to use at most
+// Post: outputFile is an interleaved binary file of the n evaluations
+// Throws: -1 if the file holds no coefficients
+//         -2 if a file could not be opened, read or written
+//         -3 if the header is not one this reader understands
+//         -4 if n has no split into rows and columns that fit the budget
+int outOfCoreFFT(const std::string &inputFile, const std::string &outputFile, size_t memoryBudget)
+{
+   int in = open(inputFile.c_str(), O_RDONLY);
+   if(in < 0)
+   {
+      return -2;
+   }
+   struct stat info;
+   PolyFileHeader header;
+   if(fstat(in, &info) != 0 || !readAt(in, &header, sizeof(header), 0))
+   {
+      close(in);
+      return -2;
+   }
+   if(checkPolyFileHeader(header, info.st_size) < 0)
+   {
+      close(in);
+      return -3;
+   }
+   if(header.count == 0)
+   {
+      close(in);
+      return -1;
+   }
+   uint64_t n = header.count;
+
+   //largest divisor of n up to its square root
+   uint64_t n1 = sqrt((double)n);
+   while(n1*n1 > n)
+   {
+      n1--;
+   }
+   while(n % n1 != 0)
+   {
+      n1--;
+   }
+   uint64_t n2 = n/n1;
+
+   //what the blocks may use of the budget
+   bool inMemory = 256*n + 4096 <= memoryBudget && n <= 0x7fffffff;
+   //the plans of n1 and n2 (Bluestein's included), the twiddle tables, the
+   //staging of one row and the FFT scratch memory
+   size_t overhead = 192*(n1+n2) + 32*n2 + workspaceBytes(std::min<uint64_t>(n2, 0x7fffffff));
+   uint64_t capacity = memoryBudget > overhead ? (memoryBudget-overhead)/3/sizeof(Poly) : 0;
+   if(!inMemory && (n1 == 1 || capacity < n2 || n2 > 0x7fffffff))
+   {
+      close(in);
+      return -4;
+   }
+
+   int out = open(outputFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+   PolyFileHeader outHeader = makePolyFileHeader(n, LAYOUT_INTERLEAVED);
+   if(out < 0 || !writeAt(out, &outHeader, sizeof(outHeader), 0) ||
+      ftruncate(out, sizeof(outHeader) + n*sizeof(Poly)) != 0)
+   {
+      close(in);
+      if(out >= 0)
+      {
+         close(out);
+      }
+      return -2;
+   }
+   int retVal = 0;
+   if(inMemory)
+   {
+      std::vector<Poly> values(n);
+      std::vector<double> stage(header.layout == LAYOUT_SPLIT ? 2*n : 0);
+      if(!readCoefficients(in, header, 0, n, &values[0], stage.data()))
+      {
+         retVal = -2;
+      }
+      else
+      {
+         fft(values);
+         retVal = writeAt(out, &values[0], n*sizeof(Poly), sizeof(outHeader)) ? 0 : -2;
+      }
+      close(in);
+      close(out);
+      return retVal;
+   }
+
+   std::string scratchFile = outputFile + ".scratch";
+   int scratch = open(scratchFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+   if(scratch < 0)
+   {
+      close(in);
+      close(out);
+      return -2;
+   }
+   unlink(scratchFile.c_str());
+
+   //w^r for r < n1 and w^(q*n1) for q < n2 make up every twiddle w^(j2*k1)
+   std::vector<Poly> fine(n1), coarse(n2);
+   for(uint64_t r=0; r<n1; r++)
+   {
+      double re, im;
+      rootOfUnity<double>(r, n, re, im);
+      fine[r] = Poly(re, im);
+   }
+   for(uint64_t q=0; q<n2; q++)
+   {
+      double re, im;
+      rootOfUnity<double>(q, n2, re, im);
+      coarse[q] = Poly(re, im);
+   }
+
+   int width = std::min<uint64_t>(n2, capacity/n1);
+   int height = std::min<uint64_t>(n1, capacity/n2);
+   std::vector<Poly> storage(3*std::max(width*n1, height*n2));
+   Poly *buffers[3];
+   for(int i=0; i<3; i++)
+   {
+      buffers[i] = &storage[i*std::max(width*n1, height*n2)];
+   }
+
+   //pass 1: columns c0 .. c0+width, each stored contiguously
+   int columnBlocks = (n2+width-1)/width;
+   retVal = pipeline(columnBlocks, buffers,
+      [&](int block, Poly *columns)
+      {
+         uint64_t c0 = (uint64_t)block*width;
+         int count = std::min<uint64_t>(width, n2-c0);
+         std::vector<Poly> row(count);
+         std::vector<double> stage(2*count);
+         for(uint64_t j1=0; j1<n1; j1++)
+         {
+            if(!readCoefficients(in, header, j1*n2+c0, count, &row[0], &stage[0]))
+            {
+               return false;
+            }
+            for(int c=0; c<count; c++)
+            {
+               columns[c*n1+j1] = row[c];
+            }
+         }
+         return true;
+      },
+      [&](int block, Poly *columns)
+      {
+         uint64_t c0 = (uint64_t)block*width;
+         int count = std::min<uint64_t>(width, n2-c0);
+         parallelFor(0, count, [&](int cBegin, int cEnd)
+         {
+            for(int c=cBegin; c<cEnd; c++)
+            {
+               Poly *column = columns+c*n1;
+               fft(column, n1);
+               for(uint64_t k1=0; k1<n1; k1++)
+               {
+                  uint64_t e = (c0+c)*k1;
+                  Poly f = fine[e%n1], g = coarse[e/n1], v = column[k1];
+                  double wReal = (f.getReal()*g.getReal())+((-1)*(f.getImag()*g.getImag()));
+                  double wImag = (f.getReal()*g.getImag())+(f.getImag()*g.getReal());
+                  column[k1] = Poly((wReal*v.getReal())+((-1)*(wImag*v.getImag())),
+                                    (wReal*v.getImag())+(wImag*v.getReal()));
+               }
+            }
+         });
+      },
+      [&](int block, Poly *columns)
+      {
+         uint64_t c0 = (uint64_t)block*width;
+         int count = std::min<uint64_t>(width, n2-c0);
+         return writeAt(scratch, columns, count*n1*sizeof(Poly), c0*n1*sizeof(Poly));
+      });
+
+   //pass 2: rows r0 .. r0+height, gathered from the columns
+   int rowBlocks = (n1+height-1)/height;
+   if(retVal == 0)
+   {
+      retVal = pipeline(rowBlocks, buffers,
+         [&](int block, Poly *rows)
+         {
+            uint64_t r0 = (uint64_t)block*height;
+            int count = std::min<uint64_t>(height, n1-r0);
+            std::vector<Poly> part(count);
+            for(uint64_t j2=0; j2<n2; j2++)
+            {
+               if(!readAt(scratch, &part[0], count*sizeof(Poly), (j2*n1+r0)*sizeof(Poly)))
+               {
+                  return false;
+               }
+               for(int i=0; i<count; i++)
+               {
+                  rows[i*n2+j2] = part[i];
+               }
+            }
+            return true;
+         },
+         [&](int block, Poly *rows)
+         {
+            uint64_t r0 = (uint64_t)block*height;
+            int count = std::min<uint64_t>(height, n1-r0);
+            parallelFor(0, count, [&](int iBegin, int iEnd)
+            {
+               for(int i=iBegin; i<iEnd; i++)
+               {
+                  fft(rows+i*n2, n2);
+               }
+            });
+         },
+         [&](int block, Poly *rows)
+         {
+            uint64_t r0 = (uint64_t)block*height;
+            int count = std::min<uint64_t>(height, n1-r0);
+            std::vector<Poly> part(count);
+            for(uint64_t k2=0; k2<n2; k2++)
+            {
+               for(int i=0; i<count; i++)
+               {
+                  part[i] = rows[i*n2+k2];
+               }
+               if(!writeAt(out, &part[0], count*sizeof(Poly), sizeof(outHeader) + (k2*n1+r0)*sizeof(Poly)))
+               {
+                  return false;
+               }
+            }
+            return true;
+         });
+   }
+   close(scratch);
+   close(in);
+   if(close(out) != 0)
+   {
+      retVal = -2;
+   }
+   return retVal;
+}
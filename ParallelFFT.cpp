@@ -0,0 +1,115 @@
+#include "AlgImpl.h"
+
+//blocks of this many points or fewer are transformed serially by one thread
+static std::atomic<int> fftGrainSize(1 << 15);
+
+// This function sets the grain size of the parallel FFT: subtrees of at most
+// this many points run as one serial task. Smaller grains give more tasks to
+// balance, larger ones keep more of each task in cache.
+// Pre: grain >= 2, a power of two
+void setFFTGrainSize(int grain)
+{
+   fftGrainSize = std::max(2, grain);
+}
+
+int getFFTGrainSize()
+{
+   return fftGrainSize;
+}
+
+// This function puts the input into bit reversed order, each thread handles
+// a range of indices and swaps every pair from its smaller end
+template <typename C>
+static void parallelBitReverse(C *polys, int n, ThreadPool &pool)
+{
+   int bits = 0;
+   while((1 << bits) < n)
+   {
+      bits++;
+   }
+   pool.parallelFor(0, n, [polys, bits](int iBegin, int iEnd)
+   {
+      for(int i=iBegin; i<iEnd; i++)
+      {
+         int rev = 0;
+         for(int b=0; b<bits; b++)
+         {
+            rev |= ((i >> b) & 1) << (bits-1-b);
+         }
+         if(i < rev)
+         {
+            std::swap(polys[i], polys[rev]);
+         }
+      }
+   });
+}
+
+// This function transforms one bit reversed block of the FFT recursively. The
+// two halves are independent, so one is spawned as a task while this thread
+// does the other, down to blocks of leafLen that run the serial passes. The
+// last butterfly pass of the block is then split over k across the pool.
+template <typename C>
+static void parallelSubtree(C *polys, int len, int leafLen, const PlanOf<C> &plan, ThreadPool &pool)
+{
+   typedef typename ScalarOf<C>::type T;
+   if(len <= leafLen)
+   {
+      radix2Passes(polys, len, plan);
+      return;
+   }
+
+   int half = len/2;
+   {
+      TaskGroup group(pool);
+      group.run([polys, half, leafLen, &plan, &pool]()
+      {
+         parallelSubtree(polys, half, leafLen, plan, pool);
+      });
+      parallelSubtree(polys+half, half, leafLen, plan, pool);
+      group.wait();
+   }
+
+   const T *twiddleReal = plan.twiddleReal(len);
+   const T *twiddleImag = plan.twiddleImag(len);
+   pool.parallelFor(0, half, [=](int kBegin, int kEnd)
+   {
+      for(int k=kBegin; k<kEnd; k++)
+      {
+         T rootReal = twiddleReal[k];
+         T rootImag = twiddleImag[k];
+         T evenReal = polys[k].getReal();
+         T evenImag = polys[k].getImag();
+         T oddReal = polys[k+half].getReal();
+         T oddImag = polys[k+half].getImag();
+         T tReal = (rootReal*oddReal)+((-1)*(rootImag*oddImag));
+         T tImag = (rootReal*oddImag)+(rootImag*oddReal);
+         polys[k] = C(evenReal+tReal, evenImag+tImag);
+         polys[k+half] = C(evenReal-tReal, evenImag-tImag);
+      }
+   });
+}
+
+// This function is the task parallel radix-2 FFT. The top log2(P) levels of
+// the recursion are spawned as tasks on the work stealing pool, below that
+// (and never below the grain size) each block is transformed serially. It
+// does exactly the same butterflies as radix2FFT, so the results match it.
+// Pre: polys - n coefficients where n is a power of two
+//      plan  - the plan for size n
+// Post: polys[k] holds the polynomial evaluated at the kth root of unity
+template <typename C>
+void parallelRadix2FFT(C *polys, int n, const PlanOf<C> &plan)
+{
+   ThreadPool &pool = getThreadPool();
+   int tasks = 1;
+   while(tasks < pool.size())
+   {
+      tasks <<= 1;
+   }
+   int leafLen = std::max(getFFTGrainSize(), n/tasks);
+   parallelBitReverse(polys, n, pool);
+   parallelSubtree(polys, n, leafLen, plan, pool);
+}
+
+template void parallelRadix2FFT<Poly>(Poly*, int, const FFTPlan&);
+template void parallelRadix2FFT<ScalarComplex<float> >(ScalarComplex<float>*, int, const BasicFFTPlan<float>&);
+template void parallelRadix2FFT<ScalarComplex<DoubleDouble> >(ScalarComplex<DoubleDouble>*, int, const BasicFFTPlan<DoubleDouble>&);
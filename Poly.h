@@ -1,3 +1,5 @@
+#ifndef POLY_H
+#define POLY_H
 #include <string>
 class Poly
 {
@@ -14,3 +16,4 @@ class Poly
       double getImag();
       std::string printPoly();
 };
+#endif
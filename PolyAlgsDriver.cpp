@@ -5,20 +5,61 @@
 *
 * Pass by reference is utilized heavily to lower execution 
 * times throughout program.
+*
+* Run without arguments for the interactive menu, or with
+* command line flags to run one or more jobs non-interactively
+* (see printUsage).
 */
 
 
-#include "AlgImpl.h"
-#include <ctime>
+#include "Benchmark.h"
+#include "PolyBinary.h"
+#include "PolyParser.h"
+#include "PolyWriter.h"
+#include "Precision.h"
+#include "IncrementalEval.h"
+#include "SparsePoly.h"
+#include "NTT.h"
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <iomanip>
+
+// One non-interactive evaluation: where the polynomial comes from, how to
+// evaluate it and where the results go
+struct Job
+{
+   int randomSize;
+   std::string inputFile;
+   std::string binaryFile;
+   EvalAlgorithm alg;
+   Precision precision;
+   int threads;
+   int reps;
+   int reserveSize;
+   std::string instrumentFile;
+   std::string outputFile;
+   std::string outputBinary;
+};
 
 void printMenu();
+void printUsage();
+int parseJob(const std::vector<std::string> &args, Job &job);
+int runJob(const Job &job, int jobNumber, std::vector<Poly> &polys, std::vector<Poly> &result);
+int runBatchMode(int argc, char **argv);
 
-int main()
+int main(int argc, char **argv)
 {
+   if(argc > 1)
+   {
+      return runBatchMode(argc, argv);
+   }
    bool goAgain = true;
    int choice;
    std::vector<Poly> polys;
    std::vector<Poly> result;
+   IncrementalEvaluator incremental;
    while(goAgain)
    {
       printMenu();
@@ -48,7 +89,8 @@ int main()
          std::cin.ignore(80, '\n');
          std::cout << "What is the filename? " ;
          getline(std::cin, fileName);
-         int retVal = polysFromFiles(fileName, polys);
+         PolyParseError error;
+         int retVal = parsePolyFile(fileName, polys, error);
          if(retVal == -1)
          {
             std::cout << "Specified file has n <= 0\n" << std::endl;
@@ -57,6 +99,10 @@ int main()
          {
             std::cout << "Error processing specified file " << std::endl;
          }
+         if(retVal == -3)
+         {
+            std::cout << fileName << ":" << error.line << ": " << error.message << std::endl;
+         }
       }
       else if(choice==3)
       {
@@ -75,10 +121,7 @@ int main()
          }
          else
          {
-            for(int i=0; i<result.size(); i++)
-            {
-               std::cout << result.at(i).printPoly() << std::endl;
-            }
+            writePolys("-", result, OUTPUT_READABLE);
          }
       }
       else if(choice==5)
@@ -90,10 +133,7 @@ int main()
          } 
          else
          {
-            for(int i=0; i<result.size(); i++)
-            {
-               std::cout << result.at(i).printPoly() << std::endl;
-            }
+            writePolys("-", result, OUTPUT_READABLE);
          }
       }
       else if(choice==6)
@@ -105,25 +145,24 @@ int main()
          }
          else
          {
-            for(int i=0; i<result.size(); i++)
-            {
-               std::cout << result.at(i).printPoly() << std::endl;
-            }
+            writePolys("-", result, OUTPUT_READABLE);
          }
       }
       else if(choice==7)
       {
          result.resize(polys.size());
-         if(callFFT(polys, result) < 0)
+         int retVal = callFFT(polys, result);
+         if(retVal == -1)
          {
             std::cout << "Please generate a polynomial before using this option" << std::endl;
          }
+         else if(retVal == -2)
+         {
+            std::cout << "The FFT does not support a polynomial of this size" << std::endl;
+         }
          else
          {
-            for(int i=0; i<result.size(); i++)
-            {
-               std::cout << result.at(i).printPoly() << std::endl;
-            }
+            writePolys("-", result, OUTPUT_READABLE);
          }
       }
       else if(choice==8)
@@ -134,19 +173,15 @@ int main()
          }
          else
          {
-            result.resize(polys.size());
-            clock_t begin_time = clock();
-            naivePolyEval(polys, result);
-            std::cout << "Naive  Eval           : " <<  float( clock () - begin_time ) /  CLOCKS_PER_SEC << std::endl;
-            begin_time = clock();
-            hornerEval(polys,result);
-            std::cout << "Horner Eval           : " <<  float( clock () - begin_time ) /  CLOCKS_PER_SEC << std::endl;
-            begin_time = clock();
-            repeatedSquaringEval(polys, result);
-            std::cout << "Repeated Squaring Eval: " <<  float( clock () - begin_time ) /  CLOCKS_PER_SEC << std::endl;
-            begin_time = clock();
-            callFFT(polys, result);
-            std::cout << "FFT Eval              : " <<  float( clock () - begin_time ) /  CLOCKS_PER_SEC << std::endl;
+            //wall clock median of a few runs after a warm-up, the polybench
+            //target does full sweeps
+            for(int alg=0; alg<ALG_COUNT; alg++)
+            {
+               BenchResult bench;
+               benchmarkAlgorithm((EvalAlgorithm)alg, polys, 1, 5, bench);
+               std::cout << std::left << std::setw(12) << algorithmName((EvalAlgorithm)alg) << ": median "
+                         << bench.medianNs/1e9 << " s, p99 " << bench.p99Ns/1e9 << " s" << std::endl;
+            }
          }
       }
       else if(choice==9)
@@ -157,22 +192,15 @@ int main()
          }
          else
          {
-            int count=0;
-            int64_t count64=0;
-            naivePolyEvalCounts(polys, count64);
-            std::cout << "Naive Eval             : " << count64 << std::endl;
-
-            count=0;
-            hornerEvalCounts(polys, count);
-            std::cout << "Horner Eval            : " << count << std::endl;
-
-            count64=0;
-            repeatedSquaringEvalCounts(polys, count64);
-            std::cout << "Repeated Squaring Eval : " << count64 << std::endl;
-
-            count=0;
-            callFFTCount(polys, count);
-            std::cout << "FFT Eval               : " << count << std::endl;
+            //one instrumented run of each, with the hardware counters where
+            //the kernel allows reading them
+            for(int alg=0; alg<ALG_COUNT; alg++)
+            {
+               InstrumentReport report;
+               instrumentEvaluation((EvalAlgorithm)alg, polys, result, true, report);
+               report.print(std::cout);
+               std::cout << std::endl;
+            }
          }
       }
       else if(choice==10)
@@ -181,9 +209,151 @@ int main()
       }
       else if(choice==11)
       {
-         for(int i=0; i<polys.size(); i++)
+         writePolys("-", polys, OUTPUT_READABLE);
+      }
+      else if(choice==12)
+      {
+         int threads;
+         std::cout << "How many threads should the evaluations use? ";
+         std::cin >> threads;
+         if(threads > 0)
+         {
+            setEvalThreads(threads);
+         }
+         else
+         {
+            std::cout << "Please input a thread count > 0!" << std::endl;
+         }
+      }
+      else if(choice==13)
+      {
+         std::string fileName;
+         std::cin.ignore(80, '\n');
+         std::cout << "What is the binary filename? " ;
+         getline(std::cin, fileName);
+         int retVal = polysFromBinary(fileName, polys);
+         if(retVal == -1)
+         {
+            std::cout << "Specified file has n <= 0\n" << std::endl;
+         }
+         else if(retVal < 0)
+         {
+            std::cout << "Error processing specified file " << std::endl;
+         }
+      }
+      else if(choice==14)
+      {
+         std::string fileName;
+         std::cin.ignore(80, '\n');
+         std::cout << "Please name the binary output file: ";
+         getline(std::cin, fileName);
+         writePolyBinary(fileName, polys, LAYOUT_INTERLEAVED);
+      }
+      else if(choice==15)
+      {
+         std::string fileName;
+         std::vector<Poly> other;
+         PolyParseError error;
+         std::cin.ignore(80, '\n');
+         std::cout << "What is the filename of the other polynomial? " ;
+         getline(std::cin, fileName);
+         if(parsePolyFile(fileName, other, error) < 0)
+         {
+            std::cout << fileName << ":" << error.line << ": " << error.message << std::endl;
+         }
+         else if(multiply(polys, other, polys) < 0)
+         {
+            std::cout << "Please generate a polynomial before using this option" << std::endl;
+         }
+         else
+         {
+            writePolys("-", polys, OUTPUT_READABLE);
+         }
+      }
+      else if(choice==16)
+      {
+         if(accuracyReport(polys, std::cout) < 0)
          {
-            std::cout << polys.at(i).printPoly() << std::endl;
+            std::cout << "Please generate a polynomial before using this option" << std::endl;
+         }
+      }
+      else if(choice==17)
+      {
+         //the kept values are reused as long as the polynomial has not been
+         //replaced through another option since
+         if(polys.size() == 0)
+         {
+            std::cout << "Please generate a polynomial before using this option" << std::endl;
+         }
+         else
+         {
+            if(incremental.size() != (int)polys.size() ||
+               memcmp(&incremental.coefficients()[0], &polys[0], polys.size()*sizeof(Poly)) != 0)
+            {
+               incremental.evaluate(polys);
+            }
+            int count;
+            std::cout << "How many coefficients should change? ";
+            std::cin >> count;
+            std::vector<int> indices;
+            std::vector<Poly> newValues;
+            for(int c=0; c<count; c++)
+            {
+               int j;
+               double real, imag;
+               std::cout << "Index, real and imaginary part of change " << c+1 << ": ";
+               std::cin >> j >> real >> imag;
+               indices.push_back(j);
+               newValues.push_back(Poly(real, imag));
+            }
+            if(incremental.update(indices, newValues) < 0)
+            {
+               std::cout << "Please input indices from 0 to " << polys.size()-1 << std::endl;
+            }
+            else
+            {
+               polys = incremental.coefficients();
+               incremental.getValues(result);
+               writePolys("-", result, OUTPUT_READABLE);
+            }
+         }
+      }
+      else if(choice==18)
+      {
+         SparsePoly sparse(polys);
+         if(sparseHornerEval(sparse, result) < 0)
+         {
+            std::cout << "Please generate a polynomial before using this option" << std::endl;
+         }
+         else
+         {
+            std::cout << sparse.nonZeros() << " of " << sparse.size() << " coefficients are nonzero" << std::endl;
+            writePolys("-", result, OUTPUT_READABLE);
+         }
+      }
+      else if(choice==19)
+      {
+         std::string fileName;
+         std::vector<Poly> other;
+         PolyParseError error;
+         std::cin.ignore(80, '\n');
+         std::cout << "What is the filename of the other polynomial? " ;
+         getline(std::cin, fileName);
+         if(parsePolyFile(fileName, other, error) < 0)
+         {
+            std::cout << fileName << ":" << error.line << ": " << error.message << std::endl;
+         }
+         else if(polys.size() == 0)
+         {
+            std::cout << "Please generate a polynomial before using this option" << std::endl;
+         }
+         else if(multiplyExact(polys, other, polys) < 0)
+         {
+            std::cout << "Both polynomials need integer coefficients whose product fits 63 bits" << std::endl;
+         }
+         else
+         {
+            writePolys("-", polys, OUTPUT_READABLE);
          }
       }
       else
@@ -204,10 +374,403 @@ void printMenu()
    std::cout << "* 5) Run Horner's polynomial evaluation alg     *" << std::endl;
    std::cout << "* 6) Run naive using repeated squaring          *" << std::endl;
    std::cout << "* 7) Run evaluation using FFT algorithm         *" << std::endl;
-   std::cout << "* 8) Time the running time of all 4 algorithms  *" << std::endl;
-   std::cout << "* 9) Count the number of complex * in each alg  *" << std::endl;
+   std::cout << "* 8) Time the running time of all algorithms    *" << std::endl;
+   std::cout << "* 9) Report flops, bytes & counters of each alg *" << std::endl;
    std::cout << "* 10) Quit Program                              *" << std::endl;
+   std::cout << "* 12) Set number of evaluation threads          *" << std::endl;
+   std::cout << "* 13) Read in Polynomial from Binary File       *" << std::endl;
+   std::cout << "* 14) Output Polynomial to Binary File          *" << std::endl;
+   std::cout << "* 15) Multiply Polynomial by one from a File    *" << std::endl;
+   std::cout << "* 16) Report accuracy of every alg & precision  *" << std::endl;
+   std::cout << "* 17) Change coefficients, update the values    *" << std::endl;
+   std::cout << "* 18) Run sparse Horner over nonzero terms      *" << std::endl;
+   std::cout << "* 19) Multiply exactly by a Polynomial (NTT)    *" << std::endl;
    std::cout << "*                                               *" << std::endl;
    std::cout << "*************************************************" << std::endl;
    std::cout << std::endl;
 }
+
+void printUsage()
+{
+   std::cout << "Usage: a.out [job options] [--jobs file]" << std::endl;
+   std::cout << "   --random n      evaluate a random polynomial of size n" << std::endl;
+   std::cout << "   --file name     evaluate the polynomial in a file" << std::endl;
+   std::cout << "   --binfile name  evaluate the polynomial in a binary file, mapped in place" << std::endl;
+   std::cout << "   --alg name      naive, horner, horner-simd, squaring or fft (default fft)" << std::endl;
+   std::cout << "   --precision p   float, double or double-double (default double)" << std::endl;
+   std::cout << "   --threads t     evaluation threads (default 1)" << std::endl;
+   std::cout << "   --reserve n     preallocate scratch memory for polynomials up to size n" << std::endl;
+   std::cout << "   --reps r        evaluate r times and report the timings (default 1)" << std::endl;
+   std::cout << "   --instrument name  write a JSON report of the flops, bytes moved," << std::endl;
+   std::cout << "                   allocations and hardware counters of one more" << std::endl;
+   std::cout << "                   evaluation to a file, - for stdout" << std::endl;
+   std::cout << "   --out name      write the results to a file, - for stdout" << std::endl;
+   std::cout << "   --out-binary name  write the results to a binary file, - for stdout" << std::endl;
+   std::cout << "   --jobs name     run every line of a file as a job, lines use the" << std::endl;
+   std::cout << "                   options above and default to the command line ones" << std::endl;
+   std::cout << "   --to-binary text binary   convert a text polynomial file to binary" << std::endl;
+   std::cout << "   --to-text binary text     convert a binary polynomial file to text" << std::endl;
+   std::cout << "   --out-of-core binary out mb  evaluate a binary polynomial file with the FFT" << std::endl;
+   std::cout << "                   into a binary file, using at most mb megabytes of memory" << std::endl;
+   std::cout << "Without arguments the interactive menu is started." << std::endl;
+}
+
+// This function reads job options into job, options that are not given keep
+// the value job already has
+// Pre: args - option names and values, job - the defaults
+// Post: job holds the options
+// Throws: -1 if an option is unknown or its value is missing or invalid
+int parseJob(const std::vector<std::string> &args, Job &job)
+{
+   for(int i=0; i<(int)args.size(); i+=2)
+   {
+      if(i+1 >= (int)args.size())
+      {
+         std::cerr << "Missing value for " << args[i] << std::endl;
+         return -1;
+      }
+      const std::string &value = args[i+1];
+      if(args[i] == "--random")
+      {
+         job.randomSize = atoi(value.c_str());
+         job.inputFile.clear();
+         job.binaryFile.clear();
+         if(job.randomSize <= 0)
+         {
+            std::cerr << "Please input n > 0!" << std::endl;
+            return -1;
+         }
+      }
+      else if(args[i] == "--file")
+      {
+         job.inputFile = value;
+         job.binaryFile.clear();
+         job.randomSize = 0;
+      }
+      else if(args[i] == "--binfile")
+      {
+         job.binaryFile = value;
+         job.inputFile.clear();
+         job.randomSize = 0;
+      }
+      else if(args[i] == "--alg")
+      {
+         if(parseAlgorithm(value, job.alg) < 0)
+         {
+            std::cerr << "Unknown algorithm " << value << std::endl;
+            return -1;
+         }
+      }
+      else if(args[i] == "--precision")
+      {
+         if(parsePrecision(value, job.precision) < 0)
+         {
+            std::cerr << "Unknown precision " << value << std::endl;
+            return -1;
+         }
+      }
+      else if(args[i] == "--threads")
+      {
+         job.threads = atoi(value.c_str());
+         if(job.threads <= 0)
+         {
+            std::cerr << "Please input a thread count > 0!" << std::endl;
+            return -1;
+         }
+      }
+      else if(args[i] == "--reserve")
+      {
+         job.reserveSize = atoi(value.c_str());
+         if(job.reserveSize <= 0)
+         {
+            std::cerr << "Please input n > 0!" << std::endl;
+            return -1;
+         }
+      }
+      else if(args[i] == "--reps")
+      {
+         job.reps = atoi(value.c_str());
+         if(job.reps <= 0)
+         {
+            std::cerr << "Please input a repetition count > 0!" << std::endl;
+            return -1;
+         }
+      }
+      else if(args[i] == "--instrument")
+      {
+         job.instrumentFile = value;
+      }
+      else if(args[i] == "--out")
+      {
+         job.outputFile = value;
+      }
+      else if(args[i] == "--out-binary")
+      {
+         job.outputBinary = value;
+      }
+      else
+      {
+         std::cerr << "Unknown option " << args[i] << std::endl;
+         return -1;
+      }
+   }
+   return 0;
+}
+
+// This function gives what tells one version of a file from the next, its
+// name, size and modification time to the nanosecond, or an empty string
+// if it is missing
+static std::string fileVersion(const std::string &fileName)
+{
+   struct stat info;
+   if(stat(fileName.c_str(), &info) != 0)
+   {
+      return "";
+   }
+   std::ostringstream version;
+   version << fileName << ":" << info.st_size << ":" << info.st_mtim.tv_sec << "." << info.st_mtim.tv_nsec;
+   return version.str();
+}
+
+// This function runs one job. polys and result are passed in from the batch
+// so their storage, like the plans and pools, stays warm between jobs, and
+// a file is only read (or mapped) again when the previous job used a
+// different one or it has changed since.
+// Post: A timing line is printed to stderr, results go to the output file
+// Throws: -1 if the job has no input or a precision --binfile does not support
+//         -2 if the input file could not be read
+int runJob(const Job &job, int jobNumber, std::vector<Poly> &polys, std::vector<Poly> &result)
+{
+   static std::string loadedFile;
+   static MappedPolyFile mapped;
+   static std::string mappedFile;
+   setEvalThreads(job.threads);
+   if(job.reserveSize > 0)
+   {
+      reserveWorkspaces(job.reserveSize);
+   }
+   BenchResult bench;
+   if(!job.binaryFile.empty() && job.precision != PRECISION_DOUBLE)
+   {
+      std::cerr << "Job " << jobNumber << ": --binfile is only evaluated in double precision" << std::endl;
+      return -1;
+   }
+   if(!job.binaryFile.empty())
+   {
+      //binary files are evaluated straight from the mapping
+      std::string version = fileVersion(job.binaryFile);
+      if(version.empty() || version != mappedFile)
+      {
+         mappedFile.clear();
+         if(mapped.open(job.binaryFile) < 0)
+         {
+            std::cerr << "Error processing specified file " << job.binaryFile << std::endl;
+            return -2;
+         }
+         mappedFile = version;
+      }
+      benchmarkRuns(job.alg, mapped.size(), [&]() { runEvaluation(job.alg, mapped, result); }, 0, job.reps, bench);
+   }
+   else
+   {
+      if(job.randomSize > 0)
+      {
+         genRandomPolys(job.randomSize, polys);
+         loadedFile.clear();
+      }
+      else if(!job.inputFile.empty())
+      {
+         std::string version = fileVersion(job.inputFile);
+         if(version.empty() || version != loadedFile)
+         {
+            loadedFile.clear();
+            PolyParseError error;
+            if(parsePolyFile(job.inputFile, polys, error) < 0)
+            {
+               std::cerr << job.inputFile << ":" << error.line << ": " << error.message << std::endl;
+               return -2;
+            }
+            loadedFile = version;
+         }
+      }
+      else
+      {
+         std::cerr << "Job " << jobNumber << " has no --random, --file or --binfile input" << std::endl;
+         return -1;
+      }
+      if(job.precision == PRECISION_DOUBLE)
+      {
+         benchmarkAlgorithm(job.alg, polys, result, 0, job.reps, bench);
+      }
+      else
+      {
+         benchmarkRuns(job.alg, polys.size(), [&]() { runEvaluation(job.alg, job.precision, polys, result); },
+                       0, job.reps, bench);
+      }
+   }
+
+   if(!job.instrumentFile.empty())
+   {
+      //one more evaluation, instrumented, on whatever input the job timed
+      InstrumentReport report;
+      startInstrumentation(algorithmName(job.alg), result.size(), true);
+      if(!job.binaryFile.empty())
+      {
+         runEvaluation(job.alg, mapped, result);
+      }
+      else
+      {
+         runEvaluation(job.alg, job.precision, polys, result);
+      }
+      stopInstrumentation(report);
+      if(job.instrumentFile == "-")
+      {
+         report.printJson(std::cout);
+      }
+      else
+      {
+         std::ofstream out(job.instrumentFile.c_str());
+         if(!out)
+         {
+            std::cerr << "Could not write " << job.instrumentFile << std::endl;
+            return -2;
+         }
+         report.printJson(out);
+      }
+   }
+
+   std::cerr << "job " << jobNumber << ": " << algorithmName(job.alg) << " " << precisionName(job.precision)
+             << " n=" << result.size()
+             << " threads=" << job.threads << " reps=" << job.reps
+             << " median " << bench.medianNs/1e9 << " s" << std::endl;
+
+   if(!job.outputFile.empty() && writePolys(job.outputFile, result, OUTPUT_TEXT) < 0)
+   {
+      std::cerr << "Could not write " << job.outputFile << std::endl;
+      return -2;
+   }
+   if(!job.outputBinary.empty() && writePolys(job.outputBinary, result, OUTPUT_BINARY) < 0)
+   {
+      std::cerr << "Could not write " << job.outputBinary << std::endl;
+      return -2;
+   }
+   return 0;
+}
+
+// This function is the non-interactive mode: the command line options make
+// one job, or the defaults for every line of a --jobs file
+// Post: Every job has been run in this process
+// Throws: 1 if an option or job failed
+int runBatchMode(int argc, char **argv)
+{
+   Job defaults;
+   defaults.randomSize = 0;
+   defaults.alg = ALG_FFT;
+   defaults.precision = PRECISION_DOUBLE;
+   defaults.threads = 1;
+   defaults.reps = 1;
+   defaults.reserveSize = 0;
+
+   std::vector<std::string> args;
+   std::string jobsFile;
+   for(int i=1; i<argc; i++)
+   {
+      std::string arg = argv[i];
+      if(arg == "--help" || arg == "-h")
+      {
+         printUsage();
+         return 0;
+      }
+      else if(arg == "--jobs" && i+1 < argc)
+      {
+         jobsFile = argv[++i];
+      }
+      else if((arg == "--to-binary" || arg == "--to-text") && i+2 < argc)
+      {
+         std::string from = argv[i+1];
+         std::string to = argv[i+2];
+         int retVal = arg == "--to-binary" ? textToBinary(from, to, LAYOUT_INTERLEAVED) : binaryToText(from, to);
+         if(retVal < 0)
+         {
+            std::cerr << "Could not convert " << from << " to " << to << std::endl;
+            return 1;
+         }
+         return 0;
+      }
+      else if(arg == "--out-of-core" && i+3 < argc)
+      {
+         std::string from = argv[i+1];
+         std::string to = argv[i+2];
+         //the budget in MB must be a whole number whose bytes fit a size_t
+         char *end;
+         errno = 0;
+         long megabytes = strtol(argv[i+3], &end, 10);
+         if(errno != 0 || end == argv[i+3] || *end != '\0' || megabytes <= 0 ||
+            (unsigned long)megabytes > (SIZE_MAX >> 20))
+         {
+            std::cerr << "Please input a memory budget in MB > 0!" << std::endl;
+            return 1;
+         }
+         size_t budget = (size_t)megabytes << 20;
+         int retVal = outOfCoreFFT(from, to, budget);
+         if(retVal == -4)
+         {
+            std::cerr << "The polynomial in " << from << " cannot be split to fit " << argv[i+3] << " MB" << std::endl;
+            return 1;
+         }
+         else if(retVal < 0)
+         {
+            std::cerr << "Could not evaluate " << from << " into " << to << std::endl;
+            return 1;
+         }
+         return 0;
+      }
+      else
+      {
+         args.push_back(arg);
+      }
+   }
+   if(parseJob(args, defaults) < 0)
+   {
+      printUsage();
+      return 1;
+   }
+
+   std::vector<Poly> polys;
+   std::vector<Poly> result;
+   if(jobsFile.empty())
+   {
+      return runJob(defaults, 1, polys, result) < 0 ? 1 : 0;
+   }
+
+   std::ifstream file(jobsFile.c_str());
+   if(!file.is_open())
+   {
+      std::cerr << "Error processing specified file " << jobsFile << std::endl;
+      return 1;
+   }
+   std::string line;
+   int jobNumber = 0;
+   int failed = 0;
+   while(getline(file, line))
+   {
+      std::istringstream iss(line);
+      std::vector<std::string> jobArgs;
+      std::string token;
+      while(iss >> token)
+      {
+         jobArgs.push_back(token);
+      }
+      if(jobArgs.empty() || jobArgs[0][0] == '#')
+      {
+         continue;
+      }
+      jobNumber++;
+      Job job = defaults;
+      if(parseJob(jobArgs, job) < 0 || runJob(job, jobNumber, polys, result) < 0)
+      {
+         failed++;
+      }
+   }
+   return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+#include "PolyBatch.h"
+
+// This function copies one polynomial into column b of the batch
+// Pre: polys has size() coefficients, 0 <= b < batchSize()
+// Post: Column b holds the coefficients of polys
+void PolyBatch::setPoly(int b, const std::vector<Poly> &polys)
+{
+   for(int j=0; j<n; j++)
+   {
+      Poly cur = polys[j];
+      set(j, b, cur.getReal(), cur.getImag());
+   }
+}
+
+// This function copies column b of the batch out as a std::vector<Poly>
+// Pre: 0 <= b < batchSize()
+// Post: polys holds the size() values of column b
+void PolyBatch::getPoly(int b, std::vector<Poly> &polys) const
+{
+   polys.resize(n);
+   for(int j=0; j<n; j++)
+   {
+      polys[j] = Poly(getReal(j, b), getImag(j, b));
+   }
+}
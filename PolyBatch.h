@@ -0,0 +1,44 @@
+#ifndef POLYBATCH_H
+#define POLYBATCH_H
+#include "PolySoA.h"
+
+// A batch of B polynomials of the same size n stored as one contiguous
+// matrix. Coefficient j of every polynomial sits next to coefficient j of the
+// others (row j, column b at j*B + b), so the batched FFT runs each butterfly
+// across a whole row with unit stride and full vector lanes. Real and
+// imaginary parts are kept in separate aligned arrays like PolySoA.
+class PolyBatch
+{
+   private:
+      int n;
+      int batch;
+      AlignedDoubles re;
+      AlignedDoubles im;
+
+   public:
+      PolyBatch() : n(0), batch(0) {}
+      PolyBatch(int n, int batch) : n(n), batch(batch), re((size_t)n*batch), im((size_t)n*batch) {}
+
+      int size() const { return n; }
+      int batchSize() const { return batch; }
+      void resize(int newN, int newBatch)
+      {
+         n = newN;
+         batch = newBatch;
+         re.resize((size_t)n*batch);
+         im.resize((size_t)n*batch);
+      }
+
+      double getReal(int j, int b) const { return re[(size_t)j*batch+b]; }
+      double getImag(int j, int b) const { return im[(size_t)j*batch+b]; }
+      void set(int j, int b, double r, double v) { re[(size_t)j*batch+b] = r; im[(size_t)j*batch+b] = v; }
+
+      double* realData() { return re.data(); }
+      double* imagData() { return im.data(); }
+      const double* realData() const { return re.data(); }
+      const double* imagData() const { return im.data(); }
+
+      void setPoly(int b, const std::vector<Poly> &polys);
+      void getPoly(int b, std::vector<Poly> &polys) const;
+};
+#endif
@@ -0,0 +1,224 @@
+/*******************************************************
+* Benchmark harness for the polynomial evaluation algorithms
+*
+* Sweeps the polynomial size over powers of two and non powers of two,
+* times every algorithm with warm-up runs and repetitions and writes the
+* statistics as CSV or JSON so runs of different builds can be compared.
+*
+* Usage: polybench [--min-log2 k] [--max-log2 k] [--warmup w] [--reps r]
+*                  [--threads t] [--algs naive,horner,...] [--max-naive n]
+*                  [--max-quadratic n] [--four-step n] [--ntt yes|no]
+*                  [--tune-multiply yes|no] [--check-format n]
+*                  [--format csv|json] [--out file]
+*
+* --ntt yes adds, at every power of two size, rows for the exact NTT
+* evaluation modulo a 62 bit prime and for the FFT and exact NTT products of
+* the polynomial with itself. Their GFLOP/s are the FFT's 5 n log2(n)
+* figure, so the rows compare as throughput against the fft row.
+*
+* --tune-multiply yes measures the sizes up to which multiply uses the
+* schoolbook product instead of FFT convolution on this machine, uses them
+* and prints them to stderr.
+*
+* --check-format n formats n doubles over the whole range as the text
+* writer does and checks that each reads back to the same value, before
+* the sweep. polybench exits with 1 if any does not.
+*/
+
+#include "Benchmark.h"
+#include "NTT.h"
+#include "PolyWriter.h"
+#include <stdlib.h>
+
+// This function returns the first prime >= n, sizes like this take the
+// Bluestein path of the FFT
+static int nextPrime(int n)
+{
+   for(;; n++)
+   {
+      bool prime = n > 1;
+      for(int d=2; d*d<=n && prime; d++)
+      {
+         if(n%d == 0)
+         {
+            prime = false;
+         }
+      }
+      if(prime)
+      {
+         return n;
+      }
+   }
+}
+
+// This function splits a comma separated list of algorithm names
+// Throws: -1 if a name is not an algorithm
+static int parseAlgorithmList(const std::string &list, std::vector<EvalAlgorithm> &algs)
+{
+   algs.clear();
+   std::istringstream iss(list);
+   std::string name;
+   while(std::getline(iss, name, ','))
+   {
+      EvalAlgorithm alg;
+      if(parseAlgorithm(name, alg) < 0)
+      {
+         return -1;
+      }
+      algs.push_back(alg);
+   }
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   int minLog2 = 4, maxLog2 = 20;
+   int warmups = 3, reps = 15, threads = 1;
+   //the O(n^3) naive algorithm and the O(n^2) ones stop at these sizes
+   int maxNaive = 1024, maxQuadratic = 16384;
+   std::string format = "csv", outName;
+   bool ntt = false, tune = false;
+   long long formatChecks = 0;
+   std::vector<EvalAlgorithm> algs;
+   for(int i=0; i<ALG_COUNT; i++)
+   {
+      algs.push_back((EvalAlgorithm)i);
+   }
+
+   for(int i=1; i<argc; i++)
+   {
+      std::string arg = argv[i];
+      if(i+1 >= argc)
+      {
+         std::cerr << "Missing value for " << arg << std::endl;
+         return 1;
+      }
+      std::string value = argv[++i];
+      if(arg == "--min-log2") minLog2 = atoi(value.c_str());
+      else if(arg == "--max-log2") maxLog2 = atoi(value.c_str());
+      else if(arg == "--warmup") warmups = atoi(value.c_str());
+      else if(arg == "--reps") reps = std::max(1, atoi(value.c_str()));
+      else if(arg == "--threads") threads = std::max(1, atoi(value.c_str()));
+      else if(arg == "--max-naive") maxNaive = atoi(value.c_str());
+      else if(arg == "--max-quadratic") maxQuadratic = atoi(value.c_str());
+      else if(arg == "--four-step") setFourStepThreshold(atoi(value.c_str()));
+      else if(arg == "--ntt") ntt = value == "yes";
+      else if(arg == "--tune-multiply") tune = value == "yes";
+      else if(arg == "--check-format") formatChecks = atoll(value.c_str());
+      else if(arg == "--format") format = value;
+      else if(arg == "--out") outName = value;
+      else if(arg == "--algs")
+      {
+         if(parseAlgorithmList(value, algs) < 0)
+         {
+            std::cerr << "Unknown algorithm in " << value << std::endl;
+            return 1;
+         }
+      }
+      else
+      {
+         std::cerr << "Unknown option " << arg << std::endl;
+         return 1;
+      }
+   }
+   if(format != "csv" && format != "json")
+   {
+      std::cerr << "Format must be csv or json" << std::endl;
+      return 1;
+   }
+   if(formatChecks > 0)
+   {
+      long long failures = checkFormatRoundTrip(formatChecks);
+      std::cerr << "format round trip: " << failures << " of " << formatChecks << " values failed" << std::endl;
+      if(failures > 0)
+      {
+         return 1;
+      }
+   }
+   setEvalThreads(threads);
+   if(tune)
+   {
+      setMultiplyCrossover(tuneMultiplyCrossover(false), false);
+      setMultiplyCrossover(tuneMultiplyCrossover(true), true);
+      std::cerr << "multiply crossover: complex " << getMultiplyCrossover(false)
+                << ", real " << getMultiplyCrossover(true) << std::endl;
+   }
+
+   //powers of two, 5-smooth sizes in between and primes just above
+   std::vector<int> sizes;
+   for(int k=minLog2; k<=maxLog2; k++)
+   {
+      sizes.push_back(1 << k);
+      if(k >= 2)
+      {
+         sizes.push_back(3 << (k-2));
+      }
+      sizes.push_back(nextPrime((1 << k)+1));
+   }
+   std::sort(sizes.begin(), sizes.end());
+   sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
+
+   std::vector<BenchResult> results;
+   std::vector<Poly> polys;
+   for(int s=0; s<(int)sizes.size(); s++)
+   {
+      int n = sizes[s];
+      genRandomPolys(n, polys);
+      for(int a=0; a<(int)algs.size(); a++)
+      {
+         if(algs[a] == ALG_NAIVE && n > maxNaive)
+         {
+            continue;
+         }
+         if(algs[a] != ALG_FFT && algs[a] != ALG_NAIVE && n > maxQuadratic)
+         {
+            continue;
+         }
+         BenchResult result;
+         benchmarkAlgorithm(algs[a], polys, warmups, reps, result);
+         results.push_back(result);
+         std::cerr << algorithmName(algs[a]) << " n=" << n << " median " << result.medianNs << " ns" << std::endl;
+      }
+      if(ntt && (n & (n-1)) == 0)
+      {
+         std::vector<uint64_t> values;
+         std::vector<Poly> product(2*n-1);
+         BenchResult result;
+         benchmarkRuns(ALG_FFT, n, [&]() { nttEval(polys, 0, values); }, warmups, reps, result);
+         result.name = "ntt";
+         results.push_back(result);
+         benchmarkRuns(ALG_FFT, n, [&]() { fftMultiply(&polys[0], n, &polys[0], n, &product[0]); },
+                       warmups, reps, result);
+         result.name = "fft-multiply";
+         results.push_back(result);
+         benchmarkRuns(ALG_FFT, n, [&]() { multiplyExact(polys, polys, product); }, warmups, reps, result);
+         result.name = "ntt-multiply";
+         results.push_back(result);
+         for(int r=results.size()-3; r<(int)results.size(); r++)
+         {
+            std::cerr << results[r].name << " n=" << n << " median " << results[r].medianNs << " ns" << std::endl;
+         }
+      }
+   }
+
+   std::ofstream file;
+   if(!outName.empty())
+   {
+      file.open(outName.c_str());
+      if(!file.is_open())
+      {
+         std::cerr << "Could not open " << outName << std::endl;
+         return 1;
+      }
+   }
+   std::ostream &out = outName.empty() ? std::cout : file;
+   if(format == "json")
+   {
+      writeBenchJSON(out, results);
+   }
+   else
+   {
+      writeBenchCSV(out, results);
+   }
+   return 0;
+}
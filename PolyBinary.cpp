@@ -0,0 +1,266 @@
+#include "PolyBinary.h"
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static_assert(sizeof(PolyFileHeader) == 64, "binary header must stay 64 bytes");
+static_assert(sizeof(Poly) == 2*sizeof(double), "Poly must match the interleaved layout");
+
+// This function fills in a header for count doubles in the given layout
+PolyFileHeader makePolyFileHeader(uint64_t count, PolyLayout layout)
+{
+   PolyFileHeader header;
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, "POLYBIN", 8);
+   header.version = POLY_BINARY_VERSION;
+   header.byteOrder = POLY_BINARY_BYTE_ORDER;
+   header.precision = sizeof(double);
+   header.layout = layout;
+   header.count = count;
+   header.dataOffset = sizeof(PolyFileHeader);
+   return header;
+}
+
+// This function checks that a header is one this reader understands and
+// that the coefficients it announces are all in the file, after the header.
+// The size check divides instead of multiplying so no field, however
+// large, can wrap it around.
+// Pre: fileSize - the size of the whole file in bytes
+// Throws: -3 if the header is not valid
+int checkPolyFileHeader(const PolyFileHeader &header, uint64_t fileSize)
+{
+   if(memcmp(header.magic, "POLYBIN", 8) != 0 || header.version != POLY_BINARY_VERSION ||
+      header.byteOrder != POLY_BINARY_BYTE_ORDER || header.precision != sizeof(double) ||
+      header.layout > LAYOUT_SPLIT || header.dataOffset % sizeof(double) != 0 ||
+      header.dataOffset < sizeof(PolyFileHeader) || header.dataOffset > fileSize ||
+      header.count > (fileSize - header.dataOffset)/(2*sizeof(double)))
+   {
+      return -3;
+   }
+   return 0;
+}
+
+// This function maps a binary polynomial file and checks its header
+// Pre: fileName - a file written by writePolyBinary
+// Post: The accessors point at the file's coefficients until close()
+// Throws: -1 if the file holds no coefficients
+//         -2 if the file could not be opened or mapped
+//         -3 if the header is not one this reader understands
+int MappedPolyFile::open(const std::string &fileName)
+{
+   close();
+   int fd = ::open(fileName.c_str(), O_RDONLY);
+   if(fd < 0)
+   {
+      return -2;
+   }
+   struct stat info;
+   if(fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(PolyFileHeader))
+   {
+      ::close(fd);
+      return -2;
+   }
+   void *mapped = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+   ::close(fd);
+   if(mapped == MAP_FAILED)
+   {
+      return -2;
+   }
+   map = mapped;
+   mapLength = info.st_size;
+   memcpy(&header, map, sizeof(header));
+
+   if(checkPolyFileHeader(header, mapLength) < 0 || header.count > (uint64_t)0x7fffffff)
+   {
+      close();
+      return -3;
+   }
+   if(header.count == 0)
+   {
+      close();
+      return -1;
+   }
+   data = reinterpret_cast<const double*>(static_cast<const char*>(map) + header.dataOffset);
+   madvise(map, mapLength, MADV_SEQUENTIAL);
+   return 0;
+}
+
+// This function unmaps the file, the accessors must not be used afterwards
+void MappedPolyFile::close()
+{
+   if(map != 0)
+   {
+      munmap(map, mapLength);
+   }
+   map = 0;
+   mapLength = 0;
+   data = 0;
+}
+
+// This function writes a polynomial in the binary format
+// Pre: fileName - file to create, polys - polynomial of size > 0
+// Post: The file holds a header and the raw coefficients in the given layout
+// Throws: -2 if the file could not be written
+int writePolyBinary(const std::string &fileName, const std::vector<Poly> &polys, PolyLayout layout)
+{
+   FILE *file = fopen(fileName.c_str(), "wb");
+   if(file == 0)
+   {
+      return -2;
+   }
+   PolyFileHeader header = makePolyFileHeader(polys.size(), layout);
+   bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+   if(layout == LAYOUT_INTERLEAVED)
+   {
+      ok = ok && fwrite(polys.data(), sizeof(Poly), polys.size(), file) == polys.size();
+   }
+   else
+   {
+      PolySoA split(polys);
+      ok = ok && fwrite(split.realData(), sizeof(double), polys.size(), file) == polys.size();
+      ok = ok && fwrite(split.imagData(), sizeof(double), polys.size(), file) == polys.size();
+   }
+   ok = (fclose(file) == 0) && ok;
+   return ok ? 0 : -2;
+}
+
+// This function writes a structure of arrays polynomial in the split layout
+// Throws: -2 if the file could not be written
+int writePolyBinary(const std::string &fileName, const PolySoA &polys)
+{
+   FILE *file = fopen(fileName.c_str(), "wb");
+   if(file == 0)
+   {
+      return -2;
+   }
+   size_t n = polys.size();
+   PolyFileHeader header = makePolyFileHeader(n, LAYOUT_SPLIT);
+   bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+   ok = ok && fwrite(polys.realData(), sizeof(double), n, file) == n;
+   ok = ok && fwrite(polys.imagData(), sizeof(double), n, file) == n;
+   ok = (fclose(file) == 0) && ok;
+   return ok ? 0 : -2;
+}
+
+// This function reads a binary polynomial file into a std::vector<Poly>, for
+// callers that want their own copy rather than the mapping
+// Throws: the error codes of MappedPolyFile::open
+int polysFromBinary(const std::string &fileName, std::vector<Poly> &polys)
+{
+   MappedPolyFile file;
+   int retVal = file.open(fileName);
+   if(retVal < 0)
+   {
+      return retVal;
+   }
+   int n = file.size();
+   if(file.getLayout() == LAYOUT_INTERLEAVED)
+   {
+      polys.assign(file.polys(), file.polys()+n);
+   }
+   else
+   {
+      polys.resize(n);
+      for(int i=0; i<n; i++)
+      {
+         polys[i] = Poly(file.realData()[i], file.imagData()[i]);
+      }
+   }
+   return 0;
+}
+
+// This function converts a text polynomial file (the polysFromFiles format)
+// to the binary format
+// Throws: the error codes of polysFromFiles, or -2 if writing failed
+int textToBinary(const std::string &textFile, const std::string &binaryFile, PolyLayout layout)
+{
+   std::vector<Poly> polys;
+   int retVal = polysFromFiles(textFile, polys);
+   if(retVal < 0)
+   {
+      return retVal;
+   }
+   return writePolyBinary(binaryFile, polys, layout);
+}
+
+// This function converts a binary polynomial file to the text format
+// Throws: the error codes of MappedPolyFile::open
+int binaryToText(const std::string &binaryFile, const std::string &textFile)
+{
+   std::vector<Poly> polys;
+   int retVal = polysFromBinary(binaryFile, polys);
+   if(retVal < 0)
+   {
+      return retVal;
+   }
+   return outputPolyFile(textFile, polys);
+}
+
+// This function evaluates a mapped polynomial with the chosen algorithm.
+// Split files feed the structure of arrays evaluators and interleaved files
+// feed the FFT straight from the mapping. The other combinations go
+// through one copy into the layout the algorithm works in, and either
+// layout reaches the FFT through callFFT.
+// Pre: file - an open mapped polynomial file
+// Post: result holds the polynomial evaluated at all nth roots of unity
+// Throws: -1 if no file is open
+int runEvaluation(EvalAlgorithm alg, const MappedPolyFile &file, std::vector<Poly> &result)
+{
+   static thread_local PolySoA coeffs, values;
+   if(!file.isOpen())
+   {
+      return -1;
+   }
+   int n = file.size();
+   if(alg == ALG_FFT)
+   {
+      if(file.getLayout() == LAYOUT_INTERLEAVED)
+      {
+         return callFFT(file.polys(), n, result);
+      }
+      //interleaved once so split files take the same real input path of
+      //callFFT
+      WorkspaceFrame frame;
+      Poly *interleaved = frame.allocate<Poly>(n);
+      for(int i=0; i<n; i++)
+      {
+         interleaved[i] = Poly(file.realData()[i], file.imagData()[i]);
+      }
+      return callFFT(interleaved, n, result);
+   }
+
+   const double *coeffReal = file.realData();
+   const double *coeffImag = file.imagData();
+   if(file.getLayout() == LAYOUT_INTERLEAVED)
+   {
+      coeffs.resize(n);
+      for(int i=0; i<n; i++)
+      {
+         Poly cur = file.polys()[i];
+         coeffs.set(i, cur.getReal(), cur.getImag());
+      }
+      coeffReal = coeffs.realData();
+      coeffImag = coeffs.imagData();
+   }
+   if(alg == ALG_NAIVE)
+   {
+      naivePolyEval(coeffReal, coeffImag, n, values);
+   }
+   else if(alg == ALG_HORNER)
+   {
+      hornerEval(coeffReal, coeffImag, n, values);
+   }
+   else if(alg == ALG_HORNER_SIMD)
+   {
+      hornerEvalSIMD(coeffReal, coeffImag, n, values, detectSimdLevel());
+   }
+   else
+   {
+      repeatedSquaringEval(coeffReal, coeffImag, n, values);
+   }
+   values.toPolys(result);
+   return 0;
+}
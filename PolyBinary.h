@@ -0,0 +1,65 @@
+#ifndef POLYBINARY_H
+#define POLYBINARY_H
+#include "AlgImpl.h"
+#include <stdint.h>
+
+#define POLY_BINARY_VERSION 1
+#define POLY_BINARY_BYTE_ORDER 0x01020304
+
+// How the coefficients follow the header: interleaved real,imag pairs (the
+// memory layout of Poly) or all real parts followed by all imaginary parts
+// (the layout of PolySoA)
+enum PolyLayout { LAYOUT_INTERLEAVED = 0, LAYOUT_SPLIT = 1 };
+
+// The 64 byte header at the start of a binary polynomial file
+struct PolyFileHeader
+{
+   char magic[8];       // "POLYBIN" and a NUL
+   uint32_t version;    // POLY_BINARY_VERSION
+   uint32_t byteOrder;  // POLY_BINARY_BYTE_ORDER as stored by the writer
+   uint32_t precision;  // bytes per real number, 8 for double
+   uint32_t layout;     // PolyLayout
+   uint64_t count;      // number of coefficients
+   uint64_t dataOffset; // bytes from the start of the file to the data
+   uint8_t reserved[24];
+};
+
+// A binary polynomial file mapped read only into memory. The accessors point
+// straight into the mapping, so nothing is copied before the evaluators
+// read the coefficients.
+class MappedPolyFile
+{
+   private:
+      void *map;
+      size_t mapLength;
+      PolyFileHeader header;
+      const double *data;
+      MappedPolyFile(const MappedPolyFile&);
+      MappedPolyFile& operator=(const MappedPolyFile&);
+
+   public:
+      MappedPolyFile() : map(0), mapLength(0), data(0) {}
+      ~MappedPolyFile() { close(); }
+      int open(const std::string &fileName);
+      void close();
+      bool isOpen() const { return map != 0; }
+
+      int size() const { return header.count; }
+      PolyLayout getLayout() const { return (PolyLayout)header.layout; }
+      // LAYOUT_INTERLEAVED only
+      const Poly* polys() const { return reinterpret_cast<const Poly*>(data); }
+      // LAYOUT_SPLIT only
+      const double* realData() const { return data; }
+      const double* imagData() const { return data+header.count; }
+};
+
+PolyFileHeader makePolyFileHeader(uint64_t count, PolyLayout layout);
+int checkPolyFileHeader(const PolyFileHeader &header, uint64_t fileSize);
+int writePolyBinary(const std::string &fileName, const std::vector<Poly> &polys, PolyLayout layout);
+int writePolyBinary(const std::string &fileName, const PolySoA &polys);
+int polysFromBinary(const std::string &fileName, std::vector<Poly> &polys);
+int textToBinary(const std::string &textFile, const std::string &binaryFile, PolyLayout layout);
+int binaryToText(const std::string &binaryFile, const std::string &textFile);
+int runEvaluation(EvalAlgorithm alg, const MappedPolyFile &file, std::vector<Poly> &result);
+int outOfCoreFFT(const std::string &inputFile, const std::string &outputFile, size_t memoryBudget);
+#endif
@@ -0,0 +1,463 @@
+#include "PolyParser.h"
+#include "ThreadPool.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+// Parser for the text format of polysFromFiles: a count line followed by one
+// "real,imag" line per coefficient. The file is read in large blocks (or
+// mapped and split into segments for several threads) and the numbers are
+// parsed in place, so no string is allocated per line.
+
+//bytes read per block by the streaming parser
+static const size_t parseBlockSize = 1 << 22;
+//longest number the parser accepts, longer ones are a malformed line
+//rather than being cut short
+static const int maxNumberLength = 127;
+
+static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+   1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// This function parses a decimal number starting at p. Numbers whose digits
+// fit in 53 bits with a power of ten up to 22 are exact as one multiply or
+// divide of two exactly representable doubles; anything else (exponents,
+// long mantissas) is copied out and handed to strtod.
+// Post: p is past the number and value holds it
+// Throws: false if there is no number at p or it is longer than
+//         maxNumberLength characters
+static bool parseNumber(const char *&p, const char *end, double &value)
+{
+   const char *start = p;
+   bool negative = false;
+   if(p < end && (*p == '-' || *p == '+'))
+   {
+      negative = *p == '-';
+      p++;
+   }
+   uint64_t mantissa = 0;
+   int digits = 0;
+   int exp10 = 0;
+   bool any = false;
+   bool exact = true;
+   while(p < end && *p >= '0' && *p <= '9')
+   {
+      if(digits < 19)
+      {
+         mantissa = mantissa*10 + (*p-'0');
+         digits += mantissa != 0;
+      }
+      else
+      {
+         exact = false;
+      }
+      p++;
+      any = true;
+   }
+   if(p < end && *p == '.')
+   {
+      p++;
+      while(p < end && *p >= '0' && *p <= '9')
+      {
+         if(digits < 19)
+         {
+            mantissa = mantissa*10 + (*p-'0');
+            digits += mantissa != 0;
+            exp10--;
+         }
+         else if(*p != '0')
+         {
+            exact = false;
+         }
+         p++;
+         any = true;
+      }
+   }
+   if(!any)
+   {
+      p = start;
+      return false;
+   }
+   if(p < end && (*p == 'e' || *p == 'E'))
+   {
+      exact = false;
+   }
+
+   if(exact && mantissa <= (1ULL << 53) && exp10 >= -22)
+   {
+      value = exp10 < 0 ? mantissa/powersOfTen[-exp10] : (double)mantissa;
+      value = negative ? -value : value;
+      return true;
+   }
+
+   //slow path, strtod wants a terminated string. strchr would also find
+   //the terminator, so a NUL in the file has to end the number explicitly.
+   char token[maxNumberLength+1];
+   const char *tokenEnd = start;
+   while(tokenEnd < end && *tokenEnd != '\0' && strchr("0123456789+-.eE", *tokenEnd) != 0)
+   {
+      tokenEnd++;
+   }
+   if(tokenEnd-start > maxNumberLength)
+   {
+      p = start;
+      return false;
+   }
+   memcpy(token, start, tokenEnd-start);
+   token[tokenEnd-start] = '\0';
+   char *stop;
+   value = strtod(token, &stop);
+   p = start + (stop-token);
+   return stop != token;
+}
+
+// This function skips spaces, tabs and a carriage return before a newline
+static void skipBlanks(const char *&p, const char *end)
+{
+   while(p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+   {
+      p++;
+   }
+}
+
+// This function parses one coefficient line "real[,imag]" in [p, end)
+// Throws: false if the line is not a coefficient
+static bool parseLine(const char *p, const char *end, double &real, double &imag)
+{
+   skipBlanks(p, end);
+   if(!parseNumber(p, end, real))
+   {
+      return false;
+   }
+   skipBlanks(p, end);
+   imag = 0;
+   if(p < end && *p == ',')
+   {
+      p++;
+      skipBlanks(p, end);
+      if(!parseNumber(p, end, imag))
+      {
+         return false;
+      }
+      skipBlanks(p, end);
+   }
+   return p == end;
+}
+
+// This function tells whether [p, end) holds only whitespace
+static bool isBlankLine(const char *p, const char *end)
+{
+   skipBlanks(p, end);
+   return p == end;
+}
+
+// This function parses the lines in [begin, end), which must start at a line
+// boundary, into out. Blank lines are skipped.
+// Pre: line - number of the first line in the file, for error messages
+//      count - coefficients parsed so far, out has room for maxCount
+// Post: count includes the coefficients of the block, line is past it
+// Throws: false with error filled in on a malformed line or too many lines
+static bool parseBlock(const char *begin, const char *end, long long &line, Poly *out,
+                       long long &count, long long maxCount, PolyParseError &error)
+{
+   const char *p = begin;
+   while(p < end)
+   {
+      const char *eol = static_cast<const char*>(memchr(p, '\n', end-p));
+      if(eol == 0)
+      {
+         eol = end;
+      }
+      if(!isBlankLine(p, eol))
+      {
+         double real, imag;
+         if(count >= maxCount)
+         {
+            error.line = line;
+            error.message = "more coefficients than the declared count";
+            return false;
+         }
+         if(!parseLine(p, eol, real, imag))
+         {
+            error.line = line;
+            error.message = "expected \"real,imag\", got \"" + std::string(p, std::min<size_t>(eol-p, 40)) + "\"";
+            return false;
+         }
+         out[count] = Poly(real, imag);
+         count++;
+      }
+      line++;
+      p = eol+1;
+   }
+   return true;
+}
+
+// This function reads the count line and checks it against the file size,
+// so a corrupt count is reported instead of allocated
+// Throws: -1 if the count is not a number > 0
+//         -3 if the count cannot fit in the file
+static int parseCount(const char *p, const char *end, long long fileSize, long long &n, PolyParseError &error)
+{
+   double count;
+   error.line = 1;
+   skipBlanks(p, end);
+   if(!parseNumber(p, end, count) || (skipBlanks(p, end), p != end) || count != (long long)count)
+   {
+      error.message = "first line must be the number of coefficients";
+      return -3;
+   }
+   n = (long long)count;
+   if(n <= 0)
+   {
+      error.message = "number of coefficients must be > 0";
+      return -1;
+   }
+   //every coefficient takes at least two bytes, a digit and a newline
+   if(n > fileSize/2 || n > 0x7fffffff)
+   {
+      error.message = "declared count is larger than the file can hold";
+      return -3;
+   }
+   return 0;
+}
+
+// This function is the streaming parser: the file is read in blocks of
+// parseBlockSize bytes, complete lines are parsed straight out of the block
+// and a partial last line is carried over to the next one
+static int parseStreaming(const std::string &fileName, std::vector<Poly> &polys, PolyParseError &error)
+{
+   FILE *file = fopen(fileName.c_str(), "rb");
+   if(file == 0)
+   {
+      error.line = 0;
+      error.message = "could not open " + fileName;
+      return -2;
+   }
+   fseek(file, 0, SEEK_END);
+   long long fileSize = ftell(file);
+   fseek(file, 0, SEEK_SET);
+
+   std::vector<char> buffer(parseBlockSize);
+   size_t carried = 0;
+   long long line = 1;
+   long long n = -1;
+   long long count = 0;
+   int retVal = 0;
+   bool atEnd = false;
+   while(!atEnd && retVal == 0)
+   {
+      if(carried == buffer.size())
+      {
+         //a single line longer than the block, grow to fit it
+         buffer.resize(buffer.size()*2);
+      }
+      size_t got = fread(&buffer[carried], 1, buffer.size()-carried, file);
+      atEnd = got < buffer.size()-carried;
+      size_t filled = carried + got;
+      const char *begin = &buffer[0];
+      const char *end = begin + filled;
+      //only whole lines are parsed until the end of the file
+      const char *lastLine = end;
+      if(!atEnd)
+      {
+         const char *search = end;
+         while(search > begin && search[-1] != '\n')
+         {
+            search--;
+         }
+         lastLine = search;
+      }
+
+      const char *p = begin;
+      if(n < 0 && p < lastLine)
+      {
+         const char *eol = static_cast<const char*>(memchr(p, '\n', lastLine-p));
+         eol = eol ? eol : lastLine;
+         retVal = parseCount(p, eol, fileSize, n, error);
+         if(retVal == 0)
+         {
+            polys.resize(n);
+            line = 2;
+            p = eol < lastLine ? eol+1 : lastLine;
+         }
+      }
+      if(retVal == 0 && n >= 0 && !parseBlock(p, lastLine, line, &polys[0], count, n, error))
+      {
+         retVal = -3;
+      }
+      carried = end-lastLine;
+      memmove(&buffer[0], lastLine, carried);
+   }
+   fclose(file);
+
+   if(retVal == 0 && n < 0)
+   {
+      error.line = 1;
+      error.message = "file is empty";
+      retVal = -1;
+   }
+   if(retVal == 0 && count != n)
+   {
+      error.line = line;
+      error.message = "declared " + std::to_string(n) + " coefficients, found " + std::to_string(count);
+      retVal = -3;
+   }
+   return retVal;
+}
+
+// This function is the parallel parser: the file is mapped and the body cut
+// into one segment per thread at line boundaries. A first pass counts the
+// lines and coefficients of every segment, which gives each segment its
+// first line number and output index, and a second pass parses the
+// segments straight into place.
+static int parseParallel(const std::string &fileName, std::vector<Poly> &polys, int threads, PolyParseError &error)
+{
+   int fd = open(fileName.c_str(), O_RDONLY);
+   struct stat info;
+   if(fd < 0 || fstat(fd, &info) != 0)
+   {
+      if(fd >= 0)
+      {
+         close(fd);
+      }
+      error.line = 0;
+      error.message = "could not open " + fileName;
+      return -2;
+   }
+   long long fileSize = info.st_size;
+   if(fileSize == 0)
+   {
+      close(fd);
+      error.line = 1;
+      error.message = "file is empty";
+      return -1;
+   }
+   void *map = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if(map == MAP_FAILED)
+   {
+      return parseStreaming(fileName, polys, error);
+   }
+   madvise(map, fileSize, MADV_SEQUENTIAL);
+   const char *data = static_cast<const char*>(map);
+   const char *end = data + fileSize;
+
+   const char *eol = static_cast<const char*>(memchr(data, '\n', fileSize));
+   eol = eol ? eol : end;
+   long long n;
+   int retVal = parseCount(data, eol, fileSize, n, error);
+   if(retVal < 0)
+   {
+      munmap(map, fileSize);
+      return retVal;
+   }
+   polys.resize(n);
+
+   //segment boundaries, each moved forward to the start of a line
+   const char *body = eol < end ? eol+1 : end;
+   std::vector<const char*> bounds(threads+1);
+   bounds[0] = body;
+   bounds[threads] = end;
+   for(int s=1; s<threads; s++)
+   {
+      const char *cut = std::max(body + (end-body)*s/threads, bounds[s-1]);
+      if(cut > body && cut[-1] != '\n')
+      {
+         const char *next = static_cast<const char*>(memchr(cut, '\n', end-cut));
+         cut = next ? next+1 : end;
+      }
+      bounds[s] = cut;
+   }
+
+   std::vector<long long> lines(threads), coefficients(threads);
+   parallelFor(0, threads, [&](int sBegin, int sEnd)
+   {
+      for(int s=sBegin; s<sEnd; s++)
+      {
+         long long lineCount = 0, coefficientCount = 0;
+         const char *p = bounds[s];
+         while(p < bounds[s+1])
+         {
+            const char *next = static_cast<const char*>(memchr(p, '\n', bounds[s+1]-p));
+            next = next ? next : bounds[s+1];
+            coefficientCount += !isBlankLine(p, next);
+            lineCount++;
+            p = next+1;
+         }
+         lines[s] = lineCount;
+         coefficients[s] = coefficientCount;
+      }
+   });
+
+   long long total = 0;
+   for(int s=0; s<threads; s++)
+   {
+      total += coefficients[s];
+   }
+   if(total != n)
+   {
+      munmap(map, fileSize);
+      long long lineCount = 2;
+      for(int s=0; s<threads; s++)
+      {
+         lineCount += lines[s];
+      }
+      error.line = lineCount;
+      error.message = "declared " + std::to_string(n) + " coefficients, found " + std::to_string(total);
+      return -3;
+   }
+
+   std::vector<PolyParseError> errors(threads);
+   std::vector<char> failed(threads, 0);
+   parallelFor(0, threads, [&](int sBegin, int sEnd)
+   {
+      for(int s=sBegin; s<sEnd; s++)
+      {
+         long long line = 2, first = 0;
+         for(int prev=0; prev<s; prev++)
+         {
+            line += lines[prev];
+            first += coefficients[prev];
+         }
+         long long count = 0;
+         failed[s] = !parseBlock(bounds[s], bounds[s+1], line, &polys[first], count, coefficients[s], errors[s]);
+      }
+   });
+   munmap(map, fileSize);
+
+   //report the first failure in file order
+   for(int s=0; s<threads; s++)
+   {
+      if(failed[s])
+      {
+         error = errors[s];
+         return -3;
+      }
+   }
+   return 0;
+}
+
+// This function parses a text polynomial file (a count line then one
+// "real,imag" line per coefficient, imag optional). Files of a few MB and
+// more are split across the evaluation threads, smaller ones are streamed
+// in blocks.
+// Pre: fileName - file in the polysFromFiles format
+// Post: polys holds exactly the declared number of coefficients
+// Throws: -1 if the declared count is <= 0 or the file is empty
+//         -2 if the file could not be opened
+//         -3 if a line is malformed or the count does not match, error
+//            holds the line number and what was wrong
+int parsePolyFile(const std::string &fileName, std::vector<Poly> &polys, PolyParseError &error)
+{
+   int threads = getEvalThreads();
+   struct stat info;
+   if(threads > 1 && stat(fileName.c_str(), &info) == 0 && info.st_size >= (off_t)(4*parseBlockSize))
+   {
+      return parseParallel(fileName, polys, threads, error);
+   }
+   return parseStreaming(fileName, polys, error);
+}
@@ -0,0 +1,13 @@
+#ifndef POLYPARSER_H
+#define POLYPARSER_H
+#include "genPolys.h"
+
+// Where and why a text polynomial file failed to parse
+struct PolyParseError
+{
+   long long line;
+   std::string message;
+};
+
+int parsePolyFile(const std::string &fileName, std::vector<Poly> &polys, PolyParseError &error);
+#endif
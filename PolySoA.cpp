@@ -0,0 +1,34 @@
+#include "PolySoA.h"
+
+// This function fills the structure of arrays from the interleaved Poly form,
+// reusing the existing storage when it is already big enough
+// Pre: polys - coefficients in the std::vector<Poly> form
+// Post: This object holds the same coefficients split into real and imag arrays
+void PolySoA::fromPolys(const std::vector<Poly> &polys)
+{
+   int n = polys.size();
+   resize(n);
+   InstrumentPhase phase("split");
+   phase.count(0, 32*(int64_t)n);
+   for(int i=0; i<n; i++)
+   {
+      Poly cur = polys[i];
+      re[i] = cur.getReal();
+      im[i] = cur.getImag();
+   }
+}
+
+// This function copies the coefficients back into the interleaved Poly form
+// Pre: polys - vector to fill, resized to match if needed
+// Post: polys holds the same coefficients as this object
+void PolySoA::toPolys(std::vector<Poly> &polys) const
+{
+   int n = size();
+   polys.resize(n);
+   InstrumentPhase phase("join");
+   phase.count(0, 32*(int64_t)n);
+   for(int i=0; i<n; i++)
+   {
+      polys[i] = Poly(re[i], im[i]);
+   }
+}
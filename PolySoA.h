@@ -0,0 +1,72 @@
+#ifndef POLYSOA_H
+#define POLYSOA_H
+#include "Poly.h"
+#include "Instrumentation.h"
+#include <stdlib.h>
+#include <new>
+#include <vector>
+
+// Allocator handing out 64 byte aligned blocks so every array starts on a
+// cache line and full width vector loads never split one
+template <typename T>
+class AlignedAllocator
+{
+   public:
+      typedef T value_type;
+      template <typename U> struct rebind { typedef AlignedAllocator<U> other; };
+
+      AlignedAllocator() {}
+      template <typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+      T* allocate(std::size_t count)
+      {
+         void *block = 0;
+         if(posix_memalign(&block, 64, count*sizeof(T)) != 0)
+         {
+            throw std::bad_alloc();
+         }
+         countAllocation(count*sizeof(T));
+         return static_cast<T*>(block);
+      }
+      void deallocate(T *block, std::size_t) { free(block); }
+};
+
+template <typename T, typename U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return false; }
+
+typedef std::vector<double, AlignedAllocator<double> > AlignedDoubles;
+
+// Structure of arrays polynomial: the real and imaginary parts of the
+// coefficients live in two separate aligned arrays so the evaluators can
+// stream through them with unit stride. Accessors are inline and unchecked.
+class PolySoA
+{
+   private:
+      AlignedDoubles re;
+      AlignedDoubles im;
+
+   public:
+      PolySoA() {}
+      PolySoA(int n) : re(n), im(n) {}
+      PolySoA(const std::vector<Poly> &polys) { fromPolys(polys); }
+
+      int size() const { return re.size(); }
+      void resize(int n) { re.resize(n); im.resize(n); }
+
+      double getReal(int i) const { return re[i]; }
+      double getImag(int i) const { return im[i]; }
+      void setReal(int i, double r) { re[i] = r; }
+      void setImag(int i, double v) { im[i] = v; }
+      void set(int i, double r, double v) { re[i] = r; im[i] = v; }
+
+      double* realData() { return re.data(); }
+      double* imagData() { return im.data(); }
+      const double* realData() const { return re.data(); }
+      const double* imagData() const { return im.data(); }
+
+      void fromPolys(const std::vector<Poly> &polys);
+      void toPolys(std::vector<Poly> &polys) const;
+};
+#endif
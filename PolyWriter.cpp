@@ -0,0 +1,535 @@
+#include "PolyWriter.h"
+#include "PolyBinary.h"
+#include <string.h>
+#include <math.h>
+#include <cmath>
+#include <stdlib.h>
+#include <random>
+
+//bytes buffered before a write
+static const size_t writeBufferSize = 1 << 22;
+//longest line formatPoly produces, two doubles of at most 24 characters
+static const size_t maxLineLength = 64;
+//coefficients formatted per task by writePolys
+static const int formatBlockSize = 1 << 14;
+
+PolyWriter::PolyWriter() : file(0), ownsFile(false), failed(false), used(0)
+{
+}
+
+// This function opens the output, "-" writes to stdout
+// Throws: -2 if the file could not be created
+int PolyWriter::open(const std::string &fileName)
+{
+   close();
+   if(fileName == "-")
+   {
+      file = stdout;
+      ownsFile = false;
+   }
+   else
+   {
+      file = fopen(fileName.c_str(), "wb");
+      ownsFile = true;
+   }
+   failed = false;
+   used = 0;
+   buffer.resize(writeBufferSize);
+   return file ? 0 : -2;
+}
+
+// This function writes out what is buffered and closes the file
+// Throws: -2 if any write failed
+int PolyWriter::close()
+{
+   if(file == 0)
+   {
+      return 0;
+   }
+   flush();
+   if(ownsFile)
+   {
+      failed = (fclose(file) != 0) || failed;
+   }
+   else
+   {
+      failed = (fflush(file) != 0) || failed;
+   }
+   file = 0;
+   return failed ? -2 : 0;
+}
+
+// This function hands the buffered bytes to the file in one write
+void PolyWriter::flush()
+{
+   if(used > 0)
+   {
+      failed = (fwrite(&buffer[0], 1, used, file) != used) || failed;
+      used = 0;
+   }
+}
+
+// This function appends raw bytes, blocks larger than the buffer skip it
+void PolyWriter::write(const char *data, size_t bytes)
+{
+   if(used + bytes > buffer.size())
+   {
+      flush();
+   }
+   if(bytes >= buffer.size())
+   {
+      failed = (fwrite(data, 1, bytes, file) != bytes) || failed;
+      return;
+   }
+   memcpy(&buffer[used], data, bytes);
+   used += bytes;
+}
+
+// This function writes the count line that starts a text polynomial file
+void PolyWriter::writeCount(size_t n)
+{
+   char line[32];
+   write(line, snprintf(line, sizeof(line), "%zu\n", n));
+}
+
+// This function formats one coefficient into the buffer
+void PolyWriter::writePoly(Poly value, OutputFormat format)
+{
+   if(format == OUTPUT_BINARY)
+   {
+      write(reinterpret_cast<const char*>(&value), sizeof(Poly));
+      return;
+   }
+   if(used + maxLineLength > buffer.size())
+   {
+      flush();
+   }
+   used += formatPoly(value, format, &buffer[used]);
+}
+
+// A floating point number f*2^e with a 64 bit significand, the working type
+// of the Grisu3 shortest digit search
+struct DiyFp
+{
+   uint64_t f;
+   int e;
+};
+
+// 10^d as normalized DiyFp {f, e, d} for d = -348, -340, ..., 340
+static const struct { uint64_t f; int e; int d; } cachedPowers[] =
+{
+   {0xfa8fd5a0081c0288ULL, -1220, -348}, {0xbaaee17fa23ebf76ULL, -1193, -340},
+   {0x8b16fb203055ac76ULL, -1166, -332}, {0xcf42894a5dce35eaULL, -1140, -324},
+   {0x9a6bb0aa55653b2dULL, -1113, -316}, {0xe61acf033d1a45dfULL, -1087, -308},
+   {0xab70fe17c79ac6caULL, -1060, -300}, {0xff77b1fcbebcdc4fULL, -1034, -292},
+   {0xbe5691ef416bd60cULL, -1007, -284}, {0x8dd01fad907ffc3cULL, -980, -276},
+   {0xd3515c2831559a83ULL, -954, -268}, {0x9d71ac8fada6c9b5ULL, -927, -260},
+   {0xea9c227723ee8bcbULL, -901, -252}, {0xaecc49914078536dULL, -874, -244},
+   {0x823c12795db6ce57ULL, -847, -236}, {0xc21094364dfb5637ULL, -821, -228},
+   {0x9096ea6f3848984fULL, -794, -220}, {0xd77485cb25823ac7ULL, -768, -212},
+   {0xa086cfcd97bf97f4ULL, -741, -204}, {0xef340a98172aace5ULL, -715, -196},
+   {0xb23867fb2a35b28eULL, -688, -188}, {0x84c8d4dfd2c63f3bULL, -661, -180},
+   {0xc5dd44271ad3cdbaULL, -635, -172}, {0x936b9fcebb25c996ULL, -608, -164},
+   {0xdbac6c247d62a584ULL, -582, -156}, {0xa3ab66580d5fdaf6ULL, -555, -148},
+   {0xf3e2f893dec3f126ULL, -529, -140}, {0xb5b5ada8aaff80b8ULL, -502, -132},
+   {0x87625f056c7c4a8bULL, -475, -124}, {0xc9bcff6034c13053ULL, -449, -116},
+   {0x964e858c91ba2655ULL, -422, -108}, {0xdff9772470297ebdULL, -396, -100},
+   {0xa6dfbd9fb8e5b88fULL, -369, -92}, {0xf8a95fcf88747d94ULL, -343, -84},
+   {0xb94470938fa89bcfULL, -316, -76}, {0x8a08f0f8bf0f156bULL, -289, -68},
+   {0xcdb02555653131b6ULL, -263, -60}, {0x993fe2c6d07b7facULL, -236, -52},
+   {0xe45c10c42a2b3b06ULL, -210, -44}, {0xaa242499697392d3ULL, -183, -36},
+   {0xfd87b5f28300ca0eULL, -157, -28}, {0xbce5086492111aebULL, -130, -20},
+   {0x8cbccc096f5088ccULL, -103, -12}, {0xd1b71758e219652cULL, -77, -4},
+   {0x9c40000000000000ULL, -50, 4}, {0xe8d4a51000000000ULL, -24, 12},
+   {0xad78ebc5ac620000ULL, 3, 20}, {0x813f3978f8940984ULL, 30, 28},
+   {0xc097ce7bc90715b3ULL, 56, 36}, {0x8f7e32ce7bea5c70ULL, 83, 44},
+   {0xd5d238a4abe98068ULL, 109, 52}, {0x9f4f2726179a2245ULL, 136, 60},
+   {0xed63a231d4c4fb27ULL, 162, 68}, {0xb0de65388cc8ada8ULL, 189, 76},
+   {0x83c7088e1aab65dbULL, 216, 84}, {0xc45d1df942711d9aULL, 242, 92},
+   {0x924d692ca61be758ULL, 269, 100}, {0xda01ee641a708deaULL, 295, 108},
+   {0xa26da3999aef774aULL, 322, 116}, {0xf209787bb47d6b85ULL, 348, 124},
+   {0xb454e4a179dd1877ULL, 375, 132}, {0x865b86925b9bc5c2ULL, 402, 140},
+   {0xc83553c5c8965d3dULL, 428, 148}, {0x952ab45cfa97a0b3ULL, 455, 156},
+   {0xde469fbd99a05fe3ULL, 481, 164}, {0xa59bc234db398c25ULL, 508, 172},
+   {0xf6c69a72a3989f5cULL, 534, 180}, {0xb7dcbf5354e9beceULL, 561, 188},
+   {0x88fcf317f22241e2ULL, 588, 196}, {0xcc20ce9bd35c78a5ULL, 614, 204},
+   {0x98165af37b2153dfULL, 641, 212}, {0xe2a0b5dc971f303aULL, 667, 220},
+   {0xa8d9d1535ce3b396ULL, 694, 228}, {0xfb9b7cd9a4a7443cULL, 720, 236},
+   {0xbb764c4ca7a44410ULL, 747, 244}, {0x8bab8eefb6409c1aULL, 774, 252},
+   {0xd01fef10a657842cULL, 800, 260}, {0x9b10a4e5e9913129ULL, 827, 268},
+   {0xe7109bfba19c0c9dULL, 853, 276}, {0xac2820d9623bf429ULL, 880, 284},
+   {0x80444b5e7aa7cf85ULL, 907, 292}, {0xbf21e44003acdd2dULL, 933, 300},
+   {0x8e679c2f5e44ff8fULL, 960, 308}, {0xd433179d9c8cb841ULL, 986, 316},
+   {0x9e19db92b4e31ba9ULL, 1013, 324}, {0xeb96bf6ebadf77d9ULL, 1039, 332},
+   {0xaf87023b9bf0ee6bULL, 1066, 340}
+};
+static const uint32_t smallPowersOfTen[] = {0, 1, 10, 100, 1000, 10000, 100000, 1000000,
+   10000000, 100000000, 1000000000};
+
+// This function multiplies two DiyFp rounding the low 64 bits away
+static DiyFp multiply(DiyFp x, DiyFp y)
+{
+   unsigned __int128 product = (unsigned __int128)x.f * y.f;
+   DiyFp r = {(uint64_t)(product >> 64) + ((uint64_t)product >> 63), x.e + y.e + 64};
+   return r;
+}
+
+// This function shifts f up until its top bit is set
+static DiyFp normalize(DiyFp x)
+{
+   int shift = __builtin_clzll(x.f);
+   DiyFp r = {x.f << shift, x.e - shift};
+   return r;
+}
+
+// This function moves the last digit down while that brings it closer to
+// the value and proves the result is the closest shortest one
+// Throws: false if the digits cannot be proved right, the caller falls back
+static bool roundWeed(char *digits, int length, uint64_t distanceTooHighW, uint64_t unsafeInterval,
+                      uint64_t rest, uint64_t tenKappa, uint64_t unit)
+{
+   uint64_t smallDistance = distanceTooHighW - unit;
+   uint64_t bigDistance = distanceTooHighW + unit;
+   while(rest < smallDistance && unsafeInterval - rest >= tenKappa &&
+         (rest + tenKappa < smallDistance || smallDistance - rest >= rest + tenKappa - smallDistance))
+   {
+      digits[length-1]--;
+      rest += tenKappa;
+   }
+   if(rest < bigDistance && unsafeInterval - rest >= tenKappa &&
+      (rest + tenKappa < bigDistance || bigDistance - rest > rest + tenKappa - bigDistance))
+   {
+      return false;
+   }
+   return 2*unit <= rest && rest <= unsafeInterval - 4*unit;
+}
+
+// This function is Loitsch's Grisu3: the value and the halfway points to
+// its neighbours are scaled by a cached power of ten into 64 bit fixed
+// point, and digits are produced until they fall inside the rounding
+// interval. It fails on about 0.5% of doubles, where the 64 bit estimate
+// cannot decide the last digit.
+// Pre: value is finite and > 0
+// Post: digits holds length digits, value is digits*10^exponent
+// Throws: false when the shortest digits could not be proved
+static bool grisu3(double value, char *digits, int &length, int &exponent)
+{
+   uint64_t bits;
+   memcpy(&bits, &value, sizeof(bits));
+   uint64_t fraction = bits & 0x000FFFFFFFFFFFFFULL;
+   int biased = (int)(bits >> 52);
+   DiyFp v = {fraction, 1 - 1075};
+   if(biased != 0)
+   {
+      v.f = fraction + 0x0010000000000000ULL;
+      v.e = biased - 1075;
+   }
+   DiyFp w = normalize(v);
+   DiyFp upper = {(v.f << 1) + 1, v.e - 1};
+   upper = normalize(upper);
+   DiyFp lower = {(v.f << 1) - 1, v.e - 1};
+   //the gap below a power of two is half the gap above it
+   if(fraction == 0 && biased > 1)
+   {
+      lower.f = (v.f << 2) - 1;
+      lower.e = v.e - 2;
+   }
+   lower.f <<= lower.e - upper.e;
+   lower.e = upper.e;
+
+   //a power of ten that brings w.e into [-60, -32]
+   int k = (int)ceil((-60 - w.e - 1) * 0.30102999566398114);
+   int index = (k + 348 - 1)/8 + 1;
+   DiyFp cached = {cachedPowers[index].f, cachedPowers[index].e};
+   int cachedExponent = cachedPowers[index].d;
+
+   w = multiply(w, cached);
+   lower = multiply(lower, cached);
+   upper = multiply(upper, cached);
+
+   uint64_t unit = 1;
+   DiyFp tooLow = {lower.f - unit, lower.e};
+   DiyFp tooHigh = {upper.f + unit, upper.e};
+   uint64_t unsafeInterval = tooHigh.f - tooLow.f;
+   int shift = -w.e;
+   uint64_t one = 1ULL << shift;
+   uint32_t integral = (uint32_t)(tooHigh.f >> shift);
+   uint64_t fractional = tooHigh.f & (one - 1);
+
+   int kappa = ((64 - shift + 1)*1233 >> 12) + 1;
+   if(integral < smallPowersOfTen[kappa])
+   {
+      kappa--;
+   }
+   uint32_t divisor = smallPowersOfTen[kappa];
+   length = 0;
+   while(kappa > 0)
+   {
+      digits[length++] = '0' + integral/divisor;
+      integral %= divisor;
+      kappa--;
+      uint64_t rest = ((uint64_t)integral << shift) + fractional;
+      if(rest < unsafeInterval)
+      {
+         exponent = kappa - cachedExponent;
+         return roundWeed(digits, length, tooHigh.f - w.f, unsafeInterval, rest, (uint64_t)divisor << shift, unit);
+      }
+      divisor /= 10;
+   }
+   while(true)
+   {
+      fractional *= 10;
+      unit *= 10;
+      unsafeInterval *= 10;
+      digits[length++] = '0' + (fractional >> shift);
+      fractional &= one - 1;
+      kappa--;
+      if(fractional < unsafeInterval)
+      {
+         exponent = kappa - cachedExponent;
+         return roundWeed(digits, length, (tooHigh.f - w.f)*unit, unsafeInterval, fractional, one, unit);
+      }
+   }
+}
+
+// This function writes value with the fewest digits that read back as the
+// same double, using the closest such digits. Integers below 2^53 are
+// printed digit by digit and the rest go through Grisu3. The few values
+// Grisu3 cannot settle try 15 significant digits with printf, which is the
+// shortest form whenever one of 15 digits or fewer exists, then 16 and 17,
+// which always round trip. Either way the digits are laid out the same:
+// plain up to 17 digits before or 4 zeros after the point, otherwise with
+// an exponent written like 1e23 or 1e-7, no plus sign and no padding.
+// Pre: out has room for 26 characters
+// Post: Returns the number of characters written, out is not terminated
+int formatDouble(double value, char *out)
+{
+   int length = 0;
+   if(fabs(value) < 9007199254740992.0 && value == (double)(int64_t)value)
+   {
+      int64_t integer = (int64_t)value;
+      if(integer < 0 || (integer == 0 && signbit(value)))
+      {
+         out[length++] = '-';
+         integer = -integer;
+      }
+      char digits[20];
+      int count = 0;
+      do
+      {
+         digits[count++] = '0' + integer%10;
+         integer /= 10;
+      } while(integer > 0);
+      while(count > 0)
+      {
+         out[length++] = digits[--count];
+      }
+      return length;
+   }
+
+   char digits[20];
+   int count, exponent;
+   if(!std::isfinite(value))
+   {
+      char text[32];
+      length = snprintf(text, sizeof(text), "%g", value);
+      memcpy(out, text, length);
+      return length;
+   }
+   if(!grisu3(fabs(value), digits, count, exponent))
+   {
+      //printf's digits d.ddde+x turned into Grisu3's digits and exponent
+      char text[32];
+      for(int precision=15; precision<=17; precision++)
+      {
+         snprintf(text, sizeof(text), "%.*e", precision-1, fabs(value));
+         if(strtod(text, 0) == fabs(value))
+         {
+            break;
+         }
+      }
+      const char *e = strchr(text, 'e');
+      count = 0;
+      for(const char *c=text; c<e; c++)
+      {
+         if(*c != '.')
+         {
+            digits[count++] = *c;
+         }
+      }
+      while(count > 1 && digits[count-1] == '0')
+      {
+         count--;
+      }
+      exponent = atoi(e+1) - (count-1);
+   }
+
+   if(value < 0)
+   {
+      out[length++] = '-';
+   }
+   //digits before the decimal point, plain notation while it stays short
+   int point = count + exponent;
+   if(point > 0 && point <= 17)
+   {
+      for(int i=0; i<point; i++)
+      {
+         out[length++] = i < count ? digits[i] : '0';
+      }
+      if(count > point)
+      {
+         out[length++] = '.';
+         memcpy(out+length, digits+point, count-point);
+         length += count-point;
+      }
+   }
+   else if(point <= 0 && point > -5)
+   {
+      out[length++] = '0';
+      out[length++] = '.';
+      for(int i=point; i<0; i++)
+      {
+         out[length++] = '0';
+      }
+      memcpy(out+length, digits, count);
+      length += count;
+   }
+   else
+   {
+      out[length++] = digits[0];
+      if(count > 1)
+      {
+         out[length++] = '.';
+         memcpy(out+length, digits+1, count-1);
+         length += count-1;
+      }
+      length += snprintf(out+length, 8, "e%d", point-1);
+   }
+   return length;
+}
+
+// This function checks formatDouble on count doubles: random bit patterns
+// over the whole range, integers around 2^53, powers of ten and their
+// neighbours, and subnormals. Each must read back with strtod to the same
+// double and, past the sign, hold only digits, a point and an exponent
+// with no plus sign or leading zero.
+// Post: Returns the number of values that failed, 0 if all round trip
+long long checkFormatRoundTrip(long long count)
+{
+   std::mt19937_64 random(12345);
+   long long failures = 0;
+   for(long long i=0; i<count; i++)
+   {
+      uint64_t bits = random();
+      double value;
+      if(i%4 == 0)
+      {
+         memcpy(&value, &bits, sizeof(value));
+      }
+      else if(i%4 == 1)
+      {
+         value = 9007199254740992.0 + (double)((int64_t)(bits%2048) - 1024)*2;
+      }
+      else if(i%4 == 2)
+      {
+         value = nextafter(pow(10.0, (int)(bits%617) - 308), bits & 2048 ? INFINITY : 0);
+      }
+      else
+      {
+         value = ldexp((double)(bits >> 12), -1074);
+      }
+      if(!std::isfinite(value))
+      {
+         continue;
+      }
+      value = bits & 4096 ? -value : value;
+      char text[32];
+      int length = formatDouble(value, text);
+      text[length] = '\0';
+      const char *digits = text + (text[0] == '-');
+      const char *e = strchr(text, 'e');
+      bool wellFormed = strspn(digits, "0123456789.e-") == strlen(digits) &&
+                        (e == 0 || e[1 + (e[1] == '-')] != '0');
+      if(!wellFormed || strtod(text, 0) != value)
+      {
+         failures++;
+      }
+   }
+   return failures;
+}
+
+// This function formats one coefficient as a text or readable line
+// Pre: out has room for maxLineLength characters
+// Post: Returns the number of characters written
+int formatPoly(Poly value, OutputFormat format, char *out)
+{
+   int length = formatDouble(value.getReal(), out);
+   if(format == OUTPUT_READABLE)
+   {
+      memcpy(out+length, " + ", 3);
+      length += 3;
+      length += formatDouble(value.getImag(), out+length);
+      out[length++] = 'i';
+   }
+   else
+   {
+      out[length++] = ',';
+      length += formatDouble(value.getImag(), out+length);
+   }
+   out[length++] = '\n';
+   return length;
+}
+
+// This function writes a polynomial to a file or, for "-", to stdout. Text
+// is formatted in blocks of coefficients spread over the evaluation
+// threads and each round of blocks is written in order.
+// Pre: fileName - file to create or "-"
+// Post: OUTPUT_TEXT and OUTPUT_BINARY files read back with polysFromFiles
+//       and polysFromBinary to exactly the same values
+// Throws: -2 if the file could not be written
+int writePolys(const std::string &fileName, std::vector<Poly> &polys, OutputFormat format)
+{
+   PolyWriter writer;
+   if(writer.open(fileName) < 0)
+   {
+      return -2;
+   }
+   int n = polys.size();
+   if(format == OUTPUT_BINARY)
+   {
+      PolyFileHeader header = makePolyFileHeader(n, LAYOUT_INTERLEAVED);
+      writer.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      writer.write(reinterpret_cast<const char*>(polys.data()), n*sizeof(Poly));
+      return writer.close();
+   }
+
+   if(format == OUTPUT_TEXT)
+   {
+      writer.writeCount(n);
+   }
+   int blocks = getEvalThreads();
+   std::vector<std::vector<char> > text(blocks, std::vector<char>(formatBlockSize*maxLineLength));
+   std::vector<size_t> lengths(blocks);
+   for(int start=0; start<n; start+=blocks*formatBlockSize)
+   {
+      parallelFor(0, blocks, [&](int bBegin, int bEnd)
+      {
+         for(int b=bBegin; b<bEnd; b++)
+         {
+            int first = std::min(n, start + b*formatBlockSize);
+            int last = std::min(n, first + formatBlockSize);
+            size_t length = 0;
+            for(int i=first; i<last; i++)
+            {
+               length += formatPoly(polys[i], format, &text[b][length]);
+            }
+            lengths[b] = length;
+         }
+      });
+      for(int b=0; b<blocks; b++)
+      {
+         writer.write(&text[b][0], lengths[b]);
+      }
+   }
+   return writer.close();
+}
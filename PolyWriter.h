@@ -0,0 +1,40 @@
+#ifndef POLYWRITER_H
+#define POLYWRITER_H
+#include "genPolys.h"
+#include <stdio.h>
+
+// What writePolys produces: the "real,imag" lines read by polysFromFiles,
+// the "real + imagi" lines the menu prints, or the binary format of
+// PolyBinary.h with interleaved coefficients
+enum OutputFormat { OUTPUT_TEXT, OUTPUT_READABLE, OUTPUT_BINARY };
+
+// An output file (or stdout) with a large buffer in front of it. Numbers are
+// formatted straight into the buffer and it goes to the file in one write
+// when full, so nothing is allocated or flushed per value.
+class PolyWriter
+{
+   private:
+      FILE *file;
+      bool ownsFile;
+      bool failed;
+      std::vector<char> buffer;
+      size_t used;
+      PolyWriter(const PolyWriter&);
+      PolyWriter& operator=(const PolyWriter&);
+
+   public:
+      PolyWriter();
+      ~PolyWriter() { close(); }
+      int open(const std::string &fileName);
+      int close();
+      void flush();
+      void write(const char *data, size_t bytes);
+      void writeCount(size_t n);
+      void writePoly(Poly value, OutputFormat format);
+};
+
+int formatDouble(double value, char *out);
+long long checkFormatRoundTrip(long long count);
+int formatPoly(Poly value, OutputFormat format, char *out);
+int writePolys(const std::string &fileName, std::vector<Poly> &polys, OutputFormat format);
+#endif
@@ -0,0 +1,344 @@
+#include "Precision.h"
+#include <iomanip>
+
+// Evaluation in float and double-double. The evaluators and the FFT are
+// templated on the scalar type, so these run the same code as double, on
+// plans whose roots of unity are accurate to the precision of the type.
+
+//pi to double-double precision, hi + lo
+static const DoubleDouble ddPi(3.141592653589793116e+00, 1.224646799147353207e-16);
+//largest n the accuracy report runs the O(n^3) naive and repeated squaring evaluators at
+static const int reportCubicLimit = 256;
+
+// This function reduces the angle 2*PI*k/n to PI*a/(4n) in [0, PI/4] using
+// exact integer arithmetic, so no rounding error in the angle grows with k.
+// The flags say how the sine and cosine of the small angle map back, see
+// unreduceAngle.
+static void reduceAngle(long long k, long long n, long long &a, bool &negate, bool &rotate, bool &swap)
+{
+   k %= n;
+   if(k < 0)
+   {
+      k += n;
+   }
+   //angle is 2*PI*a/d
+   long long d = 8*n;
+   a = 8*k;
+   negate = 2*a > d;    //angle in (PI, 2*PI), take 2*PI - angle
+   if(negate)
+   {
+      a = d - a;
+   }
+   rotate = 4*a > d;    //angle in (PI/2, PI], take angle - PI/2
+   if(rotate)
+   {
+      a -= d/4;
+   }
+   swap = 8*a > d;      //angle in (PI/4, PI/2], take PI/2 - angle
+   if(swap)
+   {
+      a = d/4 - a;
+   }
+}
+
+// This function undoes the reductions of reduceAngle on a cosine and sine
+template <typename T>
+static void unreduceAngle(T c, T s, bool negate, bool rotate, bool swap, T &re, T &im)
+{
+   if(swap)
+   {
+      std::swap(c, s);
+   }
+   if(rotate)
+   {
+      T temp = c;
+      c = -s;
+      s = temp;
+   }
+   re = c;
+   im = negate ? -s : s;
+}
+
+// This function sums the Taylor series of sine and cosine in double-double,
+// 16 terms reach below 1e-40 for |x| <= PI/4
+static void ddSinCos(DoubleDouble x, DoubleDouble &s, DoubleDouble &c)
+{
+   DoubleDouble x2 = x*x;
+   DoubleDouble term = x;
+   s = x;
+   for(int k=1; k<=16; k++)
+   {
+      term = -(term*x2/DoubleDouble((2.0*k)*(2.0*k+1)));
+      s += term;
+   }
+   term = DoubleDouble(1);
+   c = DoubleDouble(1);
+   for(int k=1; k<=16; k++)
+   {
+      term = -(term*x2/DoubleDouble((2.0*k-1)*(2.0*k)));
+      c += term;
+   }
+}
+
+// This function computes e^(2*PI*i*k/n), the kth nth root of unity, to
+// double-double precision
+template <>
+void rootOfUnity<DoubleDouble>(long long k, long long n, DoubleDouble &re, DoubleDouble &im)
+{
+   long long a;
+   bool negate, rotate, swap;
+   reduceAngle(k, n, a, negate, rotate, swap);
+   DoubleDouble c, s;
+   ddSinCos(ddPi*DoubleDouble((double)a)/DoubleDouble(4.0*n), s, c);
+   unreduceAngle(c, s, negate, rotate, swap, re, im);
+}
+
+// This function is the same as above to double precision, the small angle
+// goes through long double so the result is almost always correctly rounded
+template <>
+void rootOfUnity<double>(long long k, long long n, double &re, double &im)
+{
+   long long a;
+   bool negate, rotate, swap;
+   reduceAngle(k, n, a, negate, rotate, swap);
+   long double theta = 3.14159265358979323846264338327950288L*a/(4.0L*n);
+   unreduceAngle((double)cosl(theta), (double)sinl(theta), negate, rotate, swap, re, im);
+}
+
+// This function is the same as above to single precision
+template <>
+void rootOfUnity<float>(long long k, long long n, float &re, float &im)
+{
+   double r, i;
+   rootOfUnity<double>(k, n, r, i);
+   re = r;
+   im = i;
+}
+
+// This function evaluates a polynomial at all nth roots of unity in the
+// scalar type T with the shared evaluators. The coefficients are rounded to
+// T first, into workspace memory, so once the results have been sized by a
+// previous call nothing is allocated. horner-simd runs the horner loop,
+// which the compiler vectorizes for float.
+// Pre: polys - the coefficients of the polynomial
+// Post: resultReal[k], resultImag[k] hold the polynomial evaluated at the
+//       kth root of unity
+// Throws: -1 if no polynomial exists yet
+template <typename T>
+int evaluatePrecision(EvalAlgorithm alg, const std::vector<Poly> &polys,
+                      std::vector<T> &resultReal, std::vector<T> &resultImag)
+{
+   int n = polys.size();
+   if(n == 0)
+   {
+      return -1;
+   }
+   WorkspaceFrame frame;
+   T *coeffReal = frame.allocate<T>(n);
+   T *coeffImag = frame.allocate<T>(n);
+   {
+      InstrumentPhase phase("round");
+      phase.count(0, (16 + 2*sizeof(T))*(int64_t)n);
+      for(int i=0; i<n; i++)
+      {
+         Poly coeff = polys[i];
+         coeffReal[i] = static_cast<T>(coeff.getReal());
+         coeffImag[i] = static_cast<T>(coeff.getImag());
+      }
+   }
+   resultReal.resize(n);
+   resultImag.resize(n);
+   if(alg == ALG_NAIVE)
+   {
+      naivePolyEval(coeffReal, coeffImag, n, &resultReal[0], &resultImag[0]);
+   }
+   else if(alg == ALG_REPEATED_SQUARING)
+   {
+      repeatedSquaringEval(coeffReal, coeffImag, n, &resultReal[0], &resultImag[0]);
+   }
+   else if(alg == ALG_FFT)
+   {
+      typedef typename ComplexOf<T>::type Complex;
+      Complex *values = frame.allocate<Complex>(n);
+      {
+         InstrumentPhase phase("split");
+         phase.count(0, 4*sizeof(T)*(int64_t)n);
+         for(int i=0; i<n; i++)
+         {
+            values[i] = Complex(coeffReal[i], coeffImag[i]);
+         }
+      }
+      fft(values, n);
+      InstrumentPhase phase("join");
+      phase.count(0, 4*sizeof(T)*(int64_t)n);
+      for(int k=0; k<n; k++)
+      {
+         resultReal[k] = values[k].getReal();
+         resultImag[k] = values[k].getImag();
+      }
+   }
+   else
+   {
+      hornerEval(coeffReal, coeffImag, n, &resultReal[0], &resultImag[0]);
+   }
+   return 0;
+}
+
+template int evaluatePrecision<float>(EvalAlgorithm, const std::vector<Poly>&, std::vector<float>&, std::vector<float>&);
+template int evaluatePrecision<DoubleDouble>(EvalAlgorithm, const std::vector<Poly>&,
+                                             std::vector<DoubleDouble>&, std::vector<DoubleDouble>&);
+
+// This function rounds values of any precision into result
+template <typename T>
+static void toPolys(const std::vector<T> &resultReal, const std::vector<T> &resultImag, std::vector<Poly> &result)
+{
+   result.resize(resultReal.size());
+   InstrumentPhase phase("round");
+   phase.count(0, (2*sizeof(T) + 16)*(int64_t)result.size());
+   for(int k=0; k<(int)result.size(); k++)
+   {
+      result[k] = Poly(toDouble(resultReal[k]), toDouble(resultImag[k]));
+   }
+}
+
+// This function evaluates with the chosen algorithm in the chosen precision.
+// Double runs the regular evaluators, float and double-double the
+// templated ones, with the values rounded to double afterwards.
+// Throws: -1 if no polynomial exists yet
+int runEvaluation(EvalAlgorithm alg, Precision precision, std::vector<Poly> &polys, std::vector<Poly> &result)
+{
+   if(precision == PRECISION_FLOAT)
+   {
+      static thread_local std::vector<float> real, imag;
+      int retVal = evaluatePrecision(alg, polys, real, imag);
+      toPolys(real, imag, result);
+      return retVal;
+   }
+   if(precision == PRECISION_DOUBLE_DOUBLE)
+   {
+      static thread_local std::vector<DoubleDouble> real, imag;
+      int retVal = evaluatePrecision(alg, polys, real, imag);
+      toPolys(real, imag, result);
+      return retVal;
+   }
+   return runEvaluation(alg, polys, result);
+}
+
+// This function gives the name used for a precision on the command line
+const char* precisionName(Precision precision)
+{
+   const char *names[] = {"float", "double", "double-double"};
+   return names[precision];
+}
+
+// This function looks up a precision by its command line name
+// Throws: -1 if the name is not a precision
+int parsePrecision(const std::string &name, Precision &precision)
+{
+   for(int p=0; p<PRECISION_COUNT; p++)
+   {
+      if(name == precisionName((Precision)p))
+      {
+         precision = (Precision)p;
+         return 0;
+      }
+   }
+   return -1;
+}
+
+// This function finds the largest distance between values and the
+// reference, in double-double so the reference's digits are not lost
+template <typename T>
+static double maxError(const std::vector<T> &real, const std::vector<T> &imag,
+                       const std::vector<DoubleDouble> &refReal, const std::vector<DoubleDouble> &refImag)
+{
+   double worst = 0;
+   for(int k=0; k<(int)real.size(); k++)
+   {
+      double dr = toDouble(refReal[k] - static_cast<DoubleDouble>(real[k]));
+      double di = toDouble(refImag[k] - static_cast<DoubleDouble>(imag[k]));
+      worst = std::max(worst, hypot(dr, di));
+   }
+   return worst;
+}
+
+// This function prints how far every algorithm lands from a reference in
+// every precision. The reference is horner in double-double, whose error
+// is about n*1e-32 relative to the coefficients, well below anything the
+// double results can show. The double rows use the regular evaluators, so
+// they report what runEvaluation returns.
+// Pre: polys - the coefficients of the polynomial
+// Post: A table of maximum absolute error, the error relative to the
+//       largest value and the correct digits that leaves is printed to out
+// Throws: -1 if no polynomial exists yet
+int accuracyReport(std::vector<Poly> &polys, std::ostream &out)
+{
+   int n = polys.size();
+   if(n == 0)
+   {
+      return -1;
+   }
+   std::vector<DoubleDouble> refReal, refImag;
+   evaluatePrecision(ALG_HORNER, polys, refReal, refImag);
+   double largest = 0;
+   for(int k=0; k<n; k++)
+   {
+      largest = std::max(largest, hypot(toDouble(refReal[k]), toDouble(refImag[k])));
+   }
+
+   out << "Error against horner in double-double, n=" << n << std::endl;
+   out << std::left << std::setw(13) << "algorithm" << std::setw(15) << "precision"
+       << std::setw(12) << "max error" << std::setw(12) << "relative" << "digits" << std::endl;
+   for(int alg=0; alg<ALG_COUNT; alg++)
+   {
+      for(int p=0; p<PRECISION_COUNT; p++)
+      {
+         //horner-simd only differs from horner in the double evaluators
+         if(alg == ALG_HORNER_SIMD && p != PRECISION_DOUBLE)
+         {
+            continue;
+         }
+         out << std::left << std::setw(13) << algorithmName((EvalAlgorithm)alg) << std::setw(15) << precisionName((Precision)p);
+         if((alg == ALG_NAIVE || alg == ALG_REPEATED_SQUARING) && n > reportCubicLimit)
+         {
+            out << "skipped, O(n^3) above n=" << reportCubicLimit << std::endl;
+            continue;
+         }
+         if(alg == ALG_HORNER && p == PRECISION_DOUBLE_DOUBLE)
+         {
+            out << "reference" << std::endl;
+            continue;
+         }
+         double error;
+         if(p == PRECISION_FLOAT)
+         {
+            std::vector<float> real, imag;
+            evaluatePrecision((EvalAlgorithm)alg, polys, real, imag);
+            error = maxError(real, imag, refReal, refImag);
+         }
+         else if(p == PRECISION_DOUBLE_DOUBLE)
+         {
+            std::vector<DoubleDouble> real, imag;
+            evaluatePrecision((EvalAlgorithm)alg, polys, real, imag);
+            error = maxError(real, imag, refReal, refImag);
+         }
+         else
+         {
+            std::vector<Poly> result;
+            runEvaluation((EvalAlgorithm)alg, polys, result);
+            std::vector<double> real(n), imag(n);
+            for(int k=0; k<n; k++)
+            {
+               real[k] = result[k].getReal();
+               imag[k] = result[k].getImag();
+            }
+            error = maxError(real, imag, refReal, refImag);
+         }
+         double relative = largest > 0 ? error/largest : error;
+         out << std::scientific << std::setprecision(2) << std::setw(12) << error << std::setw(12) << relative
+             << std::fixed << std::setprecision(1) << (relative > 0 ? -log10(relative) : 32.0) << std::endl;
+         out.unsetf(std::ios::floatfield);
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+#include "AlgImpl.h"
+#include "DoubleDouble.h"
+#include <ostream>
+
+// Scalar type the evaluators below work in. float halves the memory and
+// doubles the vector width of the horner loops, double-double carries about
+// 32 digits for high degree evaluation at roughly 20 times the cost.
+enum Precision { PRECISION_FLOAT, PRECISION_DOUBLE, PRECISION_DOUBLE_DOUBLE, PRECISION_COUNT };
+
+template <typename T> void rootOfUnity(long long k, long long n, T &re, T &im);
+template <typename T> int evaluatePrecision(EvalAlgorithm alg, const std::vector<Poly> &polys,
+                                            std::vector<T> &resultReal, std::vector<T> &resultImag);
+int runEvaluation(EvalAlgorithm alg, Precision precision, std::vector<Poly> &polys, std::vector<Poly> &result);
+const char* precisionName(Precision precision);
+int parsePrecision(const std::string &name, Precision &precision);
+int accuracyReport(std::vector<Poly> &polys, std::ostream &out);
+#endif
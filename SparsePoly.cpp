@@ -0,0 +1,310 @@
+#include "SparsePoly.h"
+
+//outputs computed together, so the values of a block stay in the L1 cache
+//while every term is added to them
+static const int sparseBlock = 2048;
+//largest n whose whole root table is read directly, it fits the L2 cache
+static const int directRoots = 1 << 14;
+
+// This function gives the most nonzero coefficients a polynomial of size n
+// may have for the sparse transform to be used instead of the FFT. The
+// sparse transform costs about n*nnz complex multiply-adds against the
+// FFT's n*log2(n), but a term costs a little more than a butterfly level,
+// so the limit is 3/4 of log2(n).
+int sparseTermLimit(int n)
+{
+   int log2n = 0;
+   while((1LL << log2n) < n)
+   {
+      log2n++;
+   }
+   return std::max(1, 3*log2n/4);
+}
+
+// This function adds sum over t of c_t * w^(j_t*k) to every output k, the
+// discrete Fourier transform of the count terms c_t x^(j_t). The exponent of
+// w moves on by j_t from one k to the next, so no product j*k is reduced mod
+// n inside the loop. Small sizes read w^e from the plan's table. Above that
+// the table no longer fits the cache and the strided reads would miss on
+// every k, so w^e is put together from the plan's two split root tables at
+// the cost of one more complex multiply.
+// Pre: exps - count exponents in [0, n), they may repeat
+//      plan - the plan for size n, outReal and outImag - n values each
+// Post: outReal[k] + i*outImag[k] has the terms at the kth root added
+void sparseDFT(const int *exps, const double *re, const double *im, int count, const FFTPlan &plan,
+               double *outReal, double *outImag)
+{
+   int n = plan.size();
+   bool direct = n <= directRoots;
+   InstrumentPhase phase("sparse");
+   phase.count((direct ? 8 : 14)*(int64_t)n*count, (direct ? 48 : 64)*(int64_t)n*count);
+   const double *rootReal = direct ? plan.rootsReal() : plan.fineRootsReal();
+   const double *rootImag = direct ? plan.rootsImag() : plan.fineRootsImag();
+   const double *highReal = plan.coarseRootsReal();
+   const double *highImag = plan.coarseRootsImag();
+   int shift = plan.getRootShift();
+   int mask = (1 << shift) - 1;
+   parallelFor(0, (n+sparseBlock-1)/sparseBlock, [&](int blockBegin, int blockEnd)
+   {
+      for(int block=blockBegin; block<blockEnd; block++)
+      {
+         int kBegin = block*sparseBlock;
+         int kEnd = std::min(n, kBegin+sparseBlock);
+         for(int t=0; t<count; t++)
+         {
+            int j = exps[t];
+            double cReal = re[t];
+            double cImag = im[t];
+            int e = (int64_t)j*kBegin % n;
+            for(int k=kBegin; k<kEnd; k++)
+            {
+               double wReal, wImag;
+               if(direct)
+               {
+                  wReal = rootReal[e];
+                  wImag = rootImag[e];
+               }
+               else
+               {
+                  double lowReal = rootReal[e & mask], lowImag = rootImag[e & mask];
+                  double hReal = highReal[e >> shift], hImag = highImag[e >> shift];
+                  wReal = (lowReal*hReal)+((-1)*(lowImag*hImag));
+                  wImag = (lowReal*hImag)+(lowImag*hReal);
+               }
+               outReal[k] += (cReal*wReal)+((-1)*(cImag*wImag));
+               outImag[k] += (cReal*wImag)+(cImag*wReal);
+               e += j;
+               if(e >= n)
+               {
+                  e -= n;
+               }
+            }
+         }
+      }
+   });
+}
+
+// This function changes the size of the polynomial, dropping the terms
+// whose exponents no longer fit
+void SparsePoly::resize(int newN)
+{
+   int keep = std::lower_bound(exps.begin(), exps.end(), newN) - exps.begin();
+   exps.resize(keep);
+   re.resize(keep);
+   im.resize(keep);
+   n = newN;
+}
+
+// This function sets coefficient j, a zero value removes its term
+// Pre: j - exponent of the coefficient, r + i*v - its new value
+// Post: The polynomial holds r + i*v at x^j
+// Throws: -1 if j is out of range
+int SparsePoly::set(int j, double r, double v)
+{
+   if(j < 0 || j >= n)
+   {
+      return -1;
+   }
+   int t = std::lower_bound(exps.begin(), exps.end(), j) - exps.begin();
+   bool present = t < (int)exps.size() && exps[t] == j;
+   if(r == 0 && v == 0)
+   {
+      if(present)
+      {
+         exps.erase(exps.begin()+t);
+         re.erase(re.begin()+t);
+         im.erase(im.begin()+t);
+      }
+   }
+   else if(present)
+   {
+      re[t] = r;
+      im[t] = v;
+   }
+   else
+   {
+      exps.insert(exps.begin()+t, j);
+      re.insert(re.begin()+t, r);
+      im.insert(im.begin()+t, v);
+   }
+   return 0;
+}
+
+// This function keeps the nonzero coefficients of a dense polynomial
+// Pre: polys - the n coefficients, polys[j] belongs to x^j
+// Post: The polynomial has size n and one term per nonzero coefficient
+void SparsePoly::fromPolys(const std::vector<Poly> &polys)
+{
+   n = polys.size();
+   exps.clear();
+   re.clear();
+   im.clear();
+   for(int j=0; j<n; j++)
+   {
+      Poly p = polys[j];
+      if(p.getReal() != 0 || p.getImag() != 0)
+      {
+         exps.push_back(j);
+         re.push_back(p.getReal());
+         im.push_back(p.getImag());
+      }
+   }
+}
+
+// This function writes the polynomial out densely
+// Post: polys holds n coefficients, zero where there is no term
+void SparsePoly::toPolys(std::vector<Poly> &polys) const
+{
+   polys.assign(n, Poly(0, 0));
+   for(int t=0; t<(int)exps.size(); t++)
+   {
+      polys[exps[t]] = Poly(re[t], im[t]);
+   }
+}
+
+// This function evaluates a sparse polynomial at all n roots of unity. With
+// at most sparseTermLimit(n) terms the terms are summed at every root
+// directly, otherwise the polynomial is written out densely for the FFT.
+// Pre: polys - the polynomial, result - a vector to store the values in
+// Post: result[k] holds the polynomial evaluated at the kth root of unity
+// Throws: -1 if the polynomial has size 0
+int callFFT(const SparsePoly &polys, std::vector<Poly> &result)
+{
+   int n = polys.size();
+   if(n == 0)
+   {
+      return -1;
+   }
+   if(polys.nonZeros() > sparseTermLimit(n))
+   {
+      std::vector<Poly> dense;
+      polys.toPolys(dense);
+      return callFFT(dense, result);
+   }
+   WorkspaceFrame frame;
+   double *outReal = frame.allocate<double>(n);
+   double *outImag = frame.allocate<double>(n);
+   std::fill(outReal, outReal+n, 0.0);
+   std::fill(outImag, outImag+n, 0.0);
+   sparseDFT(polys.exponents(), polys.realData(), polys.imagData(), polys.nonZeros(), *getFFTPlan(n),
+             outReal, outImag);
+   result.resize(n);
+   for(int k=0; k<n; k++)
+   {
+      result[k] = Poly(outReal[k], outImag[k]);
+   }
+   return 0;
+}
+
+// This function evaluates a sparse polynomial at all n roots of unity with
+// Horner's rule over its terms, jumping the gap d between two exponents at
+// once: at the kth root x^d is w^(k*d mod n), one lookup in the plan's
+// table, so every root costs O(nnz).
+// Pre: polys - the polynomial, result - a vector to store the values in
+// Post: result[k] holds the polynomial evaluated at the kth root of unity
+// Throws: -1 if the polynomial has size 0
+int sparseHornerEval(const SparsePoly &polys, std::vector<Poly> &result)
+{
+   int n = polys.size();
+   if(n == 0)
+   {
+      return -1;
+   }
+   std::shared_ptr<const FFTPlan> plan = getFFTPlan(n);
+   const double *rootReal = plan->rootsReal();
+   const double *rootImag = plan->rootsImag();
+   const int *exps = polys.exponents();
+   const double *re = polys.realData();
+   const double *im = polys.imagData();
+   int terms = polys.nonZeros();
+   InstrumentPhase phase("evaluate");
+   phase.count(8*(int64_t)n*terms, 40*(int64_t)n*terms);
+   result.resize(n);
+   parallelFor(0, n, [&](int kBegin, int kEnd)
+   {
+      for(int k=kBegin; k<kEnd; k++)
+      {
+         double accReal = 0, accImag = 0;
+         int above = terms > 0 ? exps[terms-1] : 0;
+         for(int t=terms-1; t>=0; t--)
+         {
+            //acc * x^(above - exps[t]) + c_t
+            int e = (int64_t)k*(above-exps[t]) % n;
+            double wReal = rootReal[e], wImag = rootImag[e];
+            double nextReal = (accReal*wReal)+((-1)*(accImag*wImag)) + re[t];
+            accImag = (accReal*wImag)+(accImag*wReal) + im[t];
+            accReal = nextReal;
+            above = exps[t];
+         }
+         int e = (int64_t)k*above % n;
+         double wReal = rootReal[e], wImag = rootImag[e];
+         result[k] = Poly((accReal*wReal)+((-1)*(accImag*wImag)), (accReal*wImag)+(accImag*wReal));
+      }
+   });
+   return 0;
+}
+
+// This function raises x to the power d by repeated squaring
+static void power(double xReal, double xImag, int d, double &outReal, double &outImag)
+{
+   outReal = 1;
+   outImag = 0;
+   while(d > 0)
+   {
+      if(d & 1)
+      {
+         double nextReal = (outReal*xReal)+((-1)*(outImag*xImag));
+         outImag = (outReal*xImag)+(outImag*xReal);
+         outReal = nextReal;
+      }
+      double squareReal = (xReal*xReal)+((-1)*(xImag*xImag));
+      xImag = 2*xReal*xImag;
+      xReal = squareReal;
+      d >>= 1;
+   }
+}
+
+// This function evaluates a sparse polynomial at any points with Horner's
+// rule over its terms. The gap d between two exponents is jumped at once
+// with x^d by repeated squaring, so a point costs O(nnz log(n/nnz))
+// multiplies instead of the O(n) of dense Horner.
+// Pre: polys - the polynomial, points - where to evaluate it
+//      result - a vector to store the values in
+// Post: result[i] holds the polynomial evaluated at points[i]
+// Throws: -1 if the polynomial has size 0 or there are no points
+int sparseHornerEvalAt(const SparsePoly &polys, const std::vector<Poly> &points, std::vector<Poly> &result)
+{
+   if(polys.size() == 0 || points.empty())
+   {
+      return -1;
+   }
+   const int *exps = polys.exponents();
+   const double *re = polys.realData();
+   const double *im = polys.imagData();
+   int terms = polys.nonZeros();
+   int count = points.size();
+   result.resize(count);
+   parallelFor(0, count, [&](int pBegin, int pEnd)
+   {
+      for(int i=pBegin; i<pEnd; i++)
+      {
+         Poly x = points[i];
+         double xReal = x.getReal(), xImag = x.getImag();
+         double accReal = 0, accImag = 0;
+         int above = terms > 0 ? exps[terms-1] : 0;
+         for(int t=terms-1; t>=0; t--)
+         {
+            double wReal, wImag;
+            power(xReal, xImag, above-exps[t], wReal, wImag);
+            double nextReal = (accReal*wReal)+((-1)*(accImag*wImag)) + re[t];
+            accImag = (accReal*wImag)+(accImag*wReal) + im[t];
+            accReal = nextReal;
+            above = exps[t];
+         }
+         double wReal, wImag;
+         power(xReal, xImag, above, wReal, wImag);
+         result[i] = Poly((accReal*wReal)+((-1)*(accImag*wImag)), (accReal*wImag)+(accImag*wReal));
+      }
+   });
+   return 0;
+}
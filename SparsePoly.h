@@ -0,0 +1,40 @@
+#ifndef SPARSEPOLY_H
+#define SPARSEPOLY_H
+#include "AlgImpl.h"
+
+// A polynomial of size n kept as its nonzero coefficients only: the
+// exponents in increasing order and the values beside them in two arrays,
+// so evaluating it costs O(nnz) per point instead of O(n)
+class SparsePoly
+{
+   private:
+      int n;
+      std::vector<int> exps;
+      std::vector<double> re;
+      std::vector<double> im;
+
+   public:
+      SparsePoly() : n(0) {}
+      SparsePoly(const std::vector<Poly> &polys) { fromPolys(polys); }
+
+      int size() const { return n; }
+      int nonZeros() const { return exps.size(); }
+      double density() const { return n == 0 ? 0 : (double)exps.size()/n; }
+
+      int getExponent(int i) const { return exps[i]; }
+      double getReal(int i) const { return re[i]; }
+      double getImag(int i) const { return im[i]; }
+      const int* exponents() const { return exps.data(); }
+      const double* realData() const { return re.data(); }
+      const double* imagData() const { return im.data(); }
+
+      void resize(int newN);
+      int set(int j, double r, double v);
+      void fromPolys(const std::vector<Poly> &polys);
+      void toPolys(std::vector<Poly> &polys) const;
+};
+
+int callFFT(const SparsePoly&, std::vector<Poly>&);
+int sparseHornerEval(const SparsePoly&, std::vector<Poly>&);
+int sparseHornerEvalAt(const SparsePoly&, const std::vector<Poly>&, std::vector<Poly>&);
+#endif
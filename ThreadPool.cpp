@@ -0,0 +1,295 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+
+//longest a waiting TaskGroup sleeps before looking for queued tasks again
+static const std::chrono::microseconds groupPollInterval(100);
+//pool and queue the current thread belongs to, -1 outside of any pool
+static thread_local const ThreadPool *currentPool = 0;
+static thread_local int currentIndex = -1;
+
+// This constructor starts threads-1 workers that wait for work
+// Pre: threads >= 1
+// Post: The pool is ready to run tasks
+ThreadPool::ThreadPool(int threads) : queued(0), stopping(false), everyThreadPending(threads-1, 0),
+                                      everyThreadLeft(0)
+{
+   //one deque per worker plus the shared one for outside threads
+   for(int i=0; i<threads; i++)
+   {
+      queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+   }
+   for(int i=1; i<threads; i++)
+   {
+      workers.push_back(std::thread(&ThreadPool::workerLoop, this, i-1));
+   }
+}
+
+// This destructor lets the workers finish queued work and joins them
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      stopping = true;
+   }
+   wake.notify_all();
+   for(int i=0; i<(int)workers.size(); i++)
+   {
+      workers[i].join();
+   }
+}
+
+// This function returns the deque the calling thread pushes to
+int ThreadPool::currentQueue() const
+{
+   if(currentPool == this)
+   {
+      return currentIndex;
+   }
+   return workers.size();
+}
+
+// This function is run by every worker, running and stealing tasks until the
+// pool stops and nothing is left
+void ThreadPool::workerLoop(int index)
+{
+   currentPool = this;
+   currentIndex = index;
+   while(true)
+   {
+      if(runPendingTask())
+      {
+         continue;
+      }
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      while(!stopping && queued.load() == 0 && !everyThreadPending[index])
+      {
+         wake.wait(lock);
+      }
+      if(everyThreadPending[index])
+      {
+         std::function<void()> task = everyThreadTask;
+         lock.unlock();
+         task();
+         lock.lock();
+         everyThreadPending[index] = 0;
+         if(--everyThreadLeft == 0)
+         {
+            everyThreadDone.notify_all();
+         }
+         continue;
+      }
+      if(stopping && queued.load() == 0)
+      {
+         return;
+      }
+   }
+}
+
+// This function queues a task on the calling thread's deque
+void ThreadPool::submit(const std::function<void()> &task)
+{
+   WorkQueue &queue = *queues[currentQueue()];
+   {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(task);
+   }
+   {
+      //taking the lock orders this with a worker about to go to sleep
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      queued++;
+   }
+   wake.notify_one();
+}
+
+// This function runs one queued task if there is any: the newest task of the
+// calling thread's own deque first, otherwise the oldest task of another one
+// Post: Returns false if every deque was empty
+bool ThreadPool::runPendingTask()
+{
+   int count = queues.size();
+   int self = currentQueue();
+   std::function<void()> task;
+   for(int i=0; i<count && !task; i++)
+   {
+      int victim = (self+i) % count;
+      WorkQueue &queue = *queues[victim];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if(queue.tasks.empty())
+      {
+         continue;
+      }
+      if(victim == self)
+      {
+         task = queue.tasks.back();
+         queue.tasks.pop_back();
+      }
+      else
+      {
+         task = queue.tasks.front();
+         queue.tasks.pop_front();
+      }
+   }
+   if(!task)
+   {
+      return false;
+   }
+   queued--;
+   task();
+   return true;
+}
+
+// This function splits [begin, end) into one contiguous chunk per thread
+// (static chunking) and runs body(chunkBegin, chunkEnd) on each, the first
+// chunk on the calling thread. Returns once every chunk has finished, and
+// may be called from inside a task.
+// Pre: body is safe to run on disjoint ranges at the same time
+// Post: body has been called on a partition of [begin, end)
+// Throws: the first exception body threw, after every chunk has finished
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int,int)> &body)
+{
+   int count = end-begin;
+   int chunks = std::min(size(), count);
+   if(chunks <= 1)
+   {
+      if(count > 0)
+      {
+         body(begin, end);
+      }
+      return;
+   }
+
+   TaskGroup group(*this);
+   for(int c=1; c<chunks; c++)
+   {
+      int chunkBegin = begin + (long long)count*c/chunks;
+      int chunkEnd = begin + (long long)count*(c+1)/chunks;
+      group.run([&body, chunkBegin, chunkEnd]()
+      {
+         body(chunkBegin, chunkEnd);
+      });
+   }
+   body(begin, begin + count/chunks);
+   group.wait();
+}
+
+// This function runs task once on the calling thread and once on every
+// worker, e.g. to set up per-thread state. Unlike a task queued per worker
+// it cannot be stolen, so no worker runs it twice and none is skipped.
+// Pre: called from outside the pool, one call at a time
+// Post: Returns once every thread has run task
+void ThreadPool::runOnEveryThread(const std::function<void()> &task)
+{
+   task();
+   std::unique_lock<std::mutex> lock(sleepMutex);
+   everyThreadTask = task;
+   everyThreadLeft = workers.size();
+   std::fill(everyThreadPending.begin(), everyThreadPending.end(), 1);
+   wake.notify_all();
+   while(everyThreadLeft > 0)
+   {
+      everyThreadDone.wait(lock);
+   }
+   everyThreadTask = nullptr;
+}
+
+// This function spawns a task that counts towards this group. The task is
+// counted off whether it returns or throws, an exception is kept for wait.
+void TaskGroup::run(const std::function<void()> &task)
+{
+   pending++;
+   pool.submit([this, task]()
+   {
+      std::exception_ptr thrown;
+      try
+      {
+         task();
+      }
+      catch(...)
+      {
+         thrown = std::current_exception();
+      }
+      //counted off under the lock, finish takes it before the group may
+      //be destroyed
+      std::lock_guard<std::mutex> lock(mutex);
+      if(thrown && !error)
+      {
+         error = thrown;
+      }
+      if(--pending == 0)
+      {
+         done.notify_all();
+      }
+   });
+}
+
+// This function returns once every task of the group has finished, running
+// other queued tasks in the meantime. With nothing to run it sleeps until
+// the last task is done, looking for newly queued tasks every
+// groupPollInterval in case one of the running tasks spawns more.
+void TaskGroup::finish()
+{
+   while(pending.load() > 0)
+   {
+      if(pool.runPendingTask())
+      {
+         continue;
+      }
+      std::unique_lock<std::mutex> lock(mutex);
+      done.wait_for(lock, groupPollInterval, [this]() { return pending.load() == 0; });
+   }
+   //the last task may still hold the lock it counted itself off under
+   std::lock_guard<std::mutex> lock(mutex);
+}
+
+// This function waits for the group like finish
+// Throws: the first exception a task of the group threw, once
+void TaskGroup::wait()
+{
+   finish();
+   std::lock_guard<std::mutex> lock(mutex);
+   if(error)
+   {
+      std::exception_ptr thrown = error;
+      error = nullptr;
+      std::rethrow_exception(thrown);
+   }
+}
+
+static std::mutex poolMutex;
+static std::unique_ptr<ThreadPool> pool;
+static int evalThreads = 1;
+
+// This function sets how many threads the evaluators use, 1 runs them serially
+// Pre: threads >= 1, no evaluation is running
+// Post: The next evaluation uses a pool of the requested size
+void setEvalThreads(int threads)
+{
+   std::lock_guard<std::mutex> lock(poolMutex);
+   if(threads < 1)
+   {
+      threads = 1;
+   }
+   if(threads != evalThreads)
+   {
+      pool.reset();
+      evalThreads = threads;
+   }
+}
+
+int getEvalThreads()
+{
+   std::lock_guard<std::mutex> lock(poolMutex);
+   return evalThreads;
+}
+
+// This function returns the shared pool, started on first use
+ThreadPool& getThreadPool()
+{
+   std::lock_guard<std::mutex> lock(poolMutex);
+   if(!pool)
+   {
+      pool.reset(new ThreadPool(evalThreads));
+   }
+   return *pool;
+}
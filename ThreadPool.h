@@ -0,0 +1,95 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <exception>
+
+// A fixed set of worker threads that the evaluators split their work across.
+// Every worker owns a deque of tasks: it pushes and pops its own tasks at the
+// back and, when it runs dry, steals from the front of the other deques, so
+// recursively spawned work spreads out on its own. Threads outside the pool
+// submit through one extra shared deque. A pool of size P has P-1 workers,
+// the calling thread does the remaining share of the work itself.
+class ThreadPool
+{
+   private:
+      struct WorkQueue
+      {
+         std::mutex mutex;
+         std::deque<std::function<void()> > tasks;
+      };
+      std::vector<std::thread> workers;
+      std::vector<std::unique_ptr<WorkQueue> > queues;
+      std::mutex sleepMutex;
+      std::condition_variable wake;
+      std::atomic<int> queued;
+      bool stopping;
+      //task every worker runs once, see runOnEveryThread
+      std::function<void()> everyThreadTask;
+      std::vector<char> everyThreadPending;
+      int everyThreadLeft;
+      std::condition_variable everyThreadDone;
+      void workerLoop(int index);
+      int currentQueue() const;
+
+   public:
+      ThreadPool(int threads);
+      ~ThreadPool();
+      int size() const { return workers.size()+1; }
+      void submit(const std::function<void()> &task);
+      bool runPendingTask();
+      void parallelFor(int begin, int end, const std::function<void(int,int)> &body);
+      void runOnEveryThread(const std::function<void()> &task);
+};
+
+// A set of tasks spawned on a pool that can be waited on together. While
+// waiting the thread runs queued tasks itself, so tasks may spawn and wait
+// on their own groups without tying up the pool. The first exception a task
+// throws is kept and rethrown by wait once every task has finished.
+class TaskGroup
+{
+   private:
+      ThreadPool &pool;
+      std::atomic<int> pending;
+      std::mutex mutex;
+      std::condition_variable done;
+      std::exception_ptr error;
+      void finish();
+
+   public:
+      TaskGroup(ThreadPool &pool) : pool(pool), pending(0) {}
+      ~TaskGroup() { finish(); }
+      void run(const std::function<void()> &task);
+      void wait();
+};
+
+void setEvalThreads(int threads);
+int getEvalThreads();
+ThreadPool& getThreadPool();
+
+// This function runs body over [begin, end) on the shared pool, directly
+// on the calling thread when the evaluators are set to one thread. It is a
+// template so the serial case calls body without wrapping it in a
+// std::function, which would allocate for most lambdas.
+template <typename Body>
+void parallelFor(int begin, int end, const Body &body)
+{
+   if(getEvalThreads() == 1)
+   {
+      if(end > begin)
+      {
+         body(begin, end);
+      }
+   }
+   else
+   {
+      getThreadPool().parallelFor(begin, end, body);
+   }
+}
+#endif
@@ -0,0 +1,203 @@
+#include "Workspace.h"
+#include "ThreadPool.h"
+#include "Instrumentation.h"
+#include "DoubleDouble.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+//bytes every thread's workspace is topped up to, see reserveWorkspaces
+static std::atomic<size_t> reservedBytes(0);
+//blocks allocated by all workspaces since the start
+static std::atomic<int64_t> blocksAllocated(0);
+
+Workspace::Workspace() : current(0), used(0), depth(0), peak(0), inUse(0)
+{
+}
+
+Workspace::~Workspace()
+{
+   freeBlocks();
+}
+
+// This function appends a 64 byte aligned block of the given size
+void Workspace::addBlock(size_t bytes)
+{
+   void *data = 0;
+   if(posix_memalign(&data, 64, bytes) != 0)
+   {
+      throw std::bad_alloc();
+   }
+   Block block;
+   block.data = static_cast<char*>(data);
+   block.size = bytes;
+   blocks.push_back(block);
+   blocksAllocated++;
+   countAllocation(bytes);
+}
+
+void Workspace::freeBlocks()
+{
+   for(int i=0; i<(int)blocks.size(); i++)
+   {
+      free(blocks[i].data);
+   }
+   blocks.clear();
+   current = 0;
+   used = 0;
+}
+
+// This function hands out the next bytes of the current block, moving on
+// to a later block when it is full. An empty block too small for the
+// request is dropped on the way, a new block is at least twice what the
+// workspace already has.
+// Pre: a WorkspaceFrame is open on this workspace
+// Post: Returns 64 byte aligned room for bytes, valid until the frame closes
+void* Workspace::allocate(size_t bytes)
+{
+   bytes = (bytes+63)/64*64;
+   inUse += bytes;
+   peak = std::max(peak, inUse);
+   while(current < (int)blocks.size() && used+bytes > blocks[current].size)
+   {
+      if(used == 0)
+      {
+         free(blocks[current].data);
+         blocks.erase(blocks.begin()+current);
+      }
+      else
+      {
+         current++;
+         used = 0;
+      }
+   }
+   if(current == (int)blocks.size())
+   {
+      addBlock(std::max(bytes, 2*capacity()));
+   }
+   void *buffer = blocks[current].data+used;
+   used += bytes;
+   return buffer;
+}
+
+// This function makes sure one block of at least bytes is there, so the
+// next evaluations that fit do not allocate
+// Pre: no frame is open on this workspace, otherwise nothing happens
+void Workspace::reserve(size_t bytes)
+{
+   if(depth > 0 || (blocks.size() == 1 && blocks[0].size >= bytes))
+   {
+      return;
+   }
+   bytes = std::max(bytes, peak);
+   freeBlocks();
+   addBlock((bytes+63)/64*64);
+}
+
+// This function gives the bytes held in all blocks
+size_t Workspace::capacity() const
+{
+   size_t total = 0;
+   for(int i=0; i<(int)blocks.size(); i++)
+   {
+      total += blocks[i].size;
+   }
+   return total;
+}
+
+WorkspaceFrame::WorkspaceFrame() : WorkspaceFrame(getWorkspace())
+{
+}
+
+WorkspaceFrame::WorkspaceFrame(Workspace &workspace) : workspace(workspace), block(workspace.current),
+                                                       used(workspace.used), inUse(workspace.inUse)
+{
+   workspace.depth++;
+}
+
+// This destructor gives back everything taken since the frame opened. The
+// outermost frame merges the blocks into one that holds the peak use.
+WorkspaceFrame::~WorkspaceFrame()
+{
+   workspace.current = block;
+   workspace.used = used;
+   workspace.inUse = inUse;
+   workspace.depth--;
+   if(workspace.depth == 0 && workspace.blocks.size() > 1)
+   {
+      size_t largest = 0;
+      for(int i=0; i<(int)workspace.blocks.size(); i++)
+      {
+         largest = std::max(largest, workspace.blocks[i].size);
+      }
+      size_t bytes = std::max(workspace.peak, largest);
+      workspace.freeBlocks();
+      workspace.addBlock(bytes);
+      workspace.peak = 0;
+   }
+}
+
+// This function returns the calling thread's workspace, grown to the size
+// reserveWorkspaces asked for if it is smaller
+Workspace& getWorkspace()
+{
+   static thread_local Workspace workspace;
+   size_t target = reservedBytes.load();
+   if(workspace.capacity() < target)
+   {
+      workspace.reserve(target);
+   }
+   return workspace;
+}
+
+// This function gives the most scratch memory one thread borrows while
+// evaluating a polynomial of size n. The largest user is the FFT in
+// double-double, the widest precision: the rounded coefficients and the
+// values they are transformed in take 32 bytes a coefficient each, and a
+// size with a prime factor above 5 adds Bluestein's convolution of the
+// power of two of at least 2n-1 points, 32 bytes a point. A four-step
+// transform of the convolution borrows a few of its sqrt sized rows and
+// columns on top, the rest covers the alignment of every buffer.
+size_t workspaceBytes(int n)
+{
+   size_t point = 2*sizeof(DoubleDouble);
+   size_t convSize = 1, side = 1;
+   while(convSize < 2*(size_t)n-1)
+   {
+      convSize <<= 1;
+   }
+   while(side*side < convSize)
+   {
+      side <<= 1;
+   }
+   return 2*point*n + point*convSize + 16*point*side + 4096;
+}
+
+// This function preallocates the workspaces of the calling thread and of
+// every thread of the evaluation pool for polynomials of up to maxN
+// coefficients, so even the first evaluation does not allocate scratch
+// memory. Pools started later by setEvalThreads grow their workspaces to
+// the same size on first use.
+// Pre: maxN > 0, no evaluation is running
+// Post: Every workspace holds at least workspaceBytes(maxN)
+void reserveWorkspaces(int maxN)
+{
+   size_t bytes = workspaceBytes(maxN);
+   if(bytes > reservedBytes.load())
+   {
+      reservedBytes = bytes;
+   }
+   getWorkspace();
+   if(getEvalThreads() > 1)
+   {
+      getThreadPool().runOnEveryThread([]() { getWorkspace(); });
+   }
+}
+
+// This function gives the number of blocks the workspaces of all threads
+// have allocated, which stops changing once evaluations reach steady state
+int64_t workspaceAllocations()
+{
+   return blocksAllocated.load();
+}
@@ -0,0 +1,66 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Scratch memory the evaluators and the FFT borrow from instead of
+// allocating their own. Every thread has one workspace, a stack of 64 byte
+// aligned blocks: a WorkspaceFrame takes buffers from the top and gives
+// them all back when it goes out of scope. When the last frame closes after
+// the memory had to grow, the blocks are merged into one big enough for
+// everything that was in use, so from the second evaluation of a size on
+// no memory is allocated.
+class Workspace
+{
+   private:
+      struct Block
+      {
+         char *data;
+         size_t size;
+      };
+      std::vector<Block> blocks;
+      int current;      //block buffers are taken from
+      size_t used;      //bytes taken from the current block
+      int depth;        //frames open on this workspace
+      size_t peak;      //most bytes in use at once since the last merge
+      size_t inUse;
+      void addBlock(size_t bytes);
+      void freeBlocks();
+
+   public:
+      Workspace();
+      ~Workspace();
+      void* allocate(size_t bytes);
+      void reserve(size_t bytes);
+      size_t capacity() const;
+      friend class WorkspaceFrame;
+};
+
+// The buffers taken from a workspace between the frame's construction and
+// destruction. Frames nest and must close in reverse order, which scoping
+// them to a block does on its own.
+class WorkspaceFrame
+{
+   private:
+      Workspace &workspace;
+      int block;
+      size_t used;
+      size_t inUse;
+
+   public:
+      WorkspaceFrame();
+      WorkspaceFrame(Workspace &workspace);
+      ~WorkspaceFrame();
+      // Uninitialised room for count values of T, 64 byte aligned
+      template <typename T> T* allocate(size_t count)
+      {
+         return static_cast<T*>(workspace.allocate(count*sizeof(T)));
+      }
+};
+
+Workspace& getWorkspace();
+size_t workspaceBytes(int n);
+void reserveWorkspaces(int maxN);
+int64_t workspaceAllocations();
+#endif
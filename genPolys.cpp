@@ -1,4 +1,6 @@
 #include "genPolys.h"
+#include "PolyParser.h"
+#include "PolyWriter.h"
 
 // This function generates a random polynomial of user defined 
 // degree
@@ -32,39 +34,11 @@ int genRandomPolys(int n, std::vector<Poly> &polys)
 //       file, returned by reference for efficiency.
 // Throws: Returns -1 if n <= 0
 //         Returns -2 if Program failed to read specified file
+//         Returns -3 if the file is malformed, see parsePolyFile
 int polysFromFiles(std::string fileName, std::vector<Poly> &polys)
 {
-   std::string line;
-   std::ifstream file (fileName.c_str());
-   if(file.is_open())
-   {
-      getline(file, line);
-      int n = atoi(line.c_str());
-      polys.resize(n);
-      if(n > 0)
-      {
-         for(int i=0; i<n; i++)
-         {
-            getline(file, line);
-            std::istringstream iss(line);
-            std::string token;
-            std::getline(iss,token,',');
-            polys.at(i).setReal(atoi(token.c_str()));
-            std::getline(iss,token,',');
-            polys.at(i).setImag(atoi(token.c_str()));
-         }
-         file.close();
-      }
-      else
-      {
-         return -1;
-      }
-   }
-   else
-   {
-      return -2;
-   }
-   return 0;
+   PolyParseError error;
+   return parsePolyFile(fileName, polys, error);
 }
 
 // This function outputs the current polynomial to a user specified file name
@@ -73,13 +47,5 @@ int polysFromFiles(std::string fileName, std::vector<Poly> &polys)
 // Post: A file will be created with the users defined file name
 int outputPolyFile(std::string fileName, std::vector<Poly> &polys)
 {
-   std::ofstream file;
-   file.open(fileName.c_str());
-   file << std::to_string(polys.size()) + "\n";
-   for(int i=0; i<polys.size(); i++)
-   {
-      file << std::to_string(polys.at(i).getReal()) + "," + std::to_string(polys.at(i).getImag()) + "\n";
-   }
-   file.close();
-   return 0;
+   return writePolys(fileName, polys, OUTPUT_TEXT);
 }
@@ -1,3 +1,5 @@
+#ifndef GENPOLYS_H
+#define GENPOLYS_H
 #include "Poly.h"
 #include <vector>
 #include <stdlib.h>
@@ -8,3 +10,4 @@
 int genRandomPolys(int n, std::vector<Poly> &polys);
 int polysFromFiles(std::string fileName, std::vector<Poly> &polys);
 int outputPolyFile(std::string fileName, std::vector<Poly> &polys);
+#endif